@@ -78,6 +78,7 @@ batch batch::writer::seal() {
 batch::reader::reader(batch const& b)
   : data_{b.data_},
     id_range_{bit_range(b.ids_)},
+    last_{select(b.ids_, -1)},
     available_{b.events()},
     charbuf_{const_cast<char*>(data_.data()), data_.size()},
     compressedbuf_{charbuf_, b.method_},
@@ -96,56 +97,34 @@ expected<std::vector<event>> batch::reader::read() {
 }
 
 expected<std::vector<event>> batch::reader::read(const bitmap& ids) {
+  return read(bitmap_skip_index{ids});
+}
+
+expected<std::vector<event>>
+batch::reader::read(const bitmap_skip_index& ids) {
   using word = typename bitmap::word_type;
   auto result = std::vector<event>{};
   if (id_range_.done())
     return result;
-  auto e = expected<event>{make_error(ec::unspecified)};
-  auto n = event_id{0};
-  auto rng = bit_range(ids);
-  auto begin = rng.begin();
-  auto end = rng.end();
-  auto next = [&](auto& bits, auto id) {
-    auto i = find_next(bits, id - n);
-    if (i != word::npos)
-      i += n;
-    return i;
-  };
-  for ( ; begin != end; n += begin->size(), ++begin) {
-    auto& bits = *begin;
-    auto first = find_first(bits);
-    if (first == word::npos)
-      continue;
-    auto id = n + first;
-    // If a previously materialized event is ahead, we must catch up first.
-    if (e && id < e->id()) {
-      id = next(bits, e->id() - 1);
-      if (id == e->id()) {
-        result.push_back(std::move(*e));
-        id = next(bits, id);
-      }
+  // Jump directly to the first ID that falls into this batch.
+  auto first = id_range_.get();
+  auto id = ids.find_next(first == 0 ? word::npos : first - 1);
+  while (id != word::npos && id <= last_) {
+    auto e = materialize();
+    if (!e) {
+      if (e.error() == ec::end_of_input) // No more events.
+        return result;
+      else
+        return e.error();
     }
-    while (id != word::npos) {
-      // Materialize events until have the one we want.
-      do {
-        e = materialize();
-        if (!e) {
-          if (e.error() == ec::end_of_input) // No more events.
-            return result;
-          else
-            return e.error();
-        }
-        VAST_ASSERT(e->id() != invalid_event_id);
-      } while (id > e->id());
-      // If the materialized event is ahead, see if the current bit sequence
-      // has the event ID.
-      if (id < e->id())
-        id = next(bits, e->id() - 1);
-      // If we have materialized the event we want, add it to the result.
-      if (id == e->id()) {
-        result.push_back(std::move(*e));
-        id = next(bits, id);
-      }
+    VAST_ASSERT(e->id() != invalid_event_id);
+    // If the materialized event is ahead, skip the IDs before it.
+    if (e->id() > id)
+      id = ids.find_next(e->id() - 1);
+    // If we have materialized the event we want, add it to the result.
+    if (e->id() == id) {
+      result.push_back(std::move(*e));
+      id = ids.find_next(id);
     }
   }
   return result;
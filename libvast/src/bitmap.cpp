@@ -63,4 +63,130 @@ bitmap_bit_range bit_range(bitmap const& bm) {
   return bitmap_bit_range{bm};
 }
 
+bitmap binary_and(bitmap const& lhs, bitmap const& rhs) {
+  auto l = get_if<ewah_bitmap>(lhs);
+  auto r = get_if<ewah_bitmap>(rhs);
+  if (l && r)
+    return binary_and(*l, *r);
+  auto op = [](auto x, auto y) { return x & y; };
+  return binary_eval<false, false>(lhs, rhs, op);
+}
+
+bitmap binary_or(bitmap const& lhs, bitmap const& rhs) {
+  auto l = get_if<ewah_bitmap>(lhs);
+  auto r = get_if<ewah_bitmap>(rhs);
+  if (l && r)
+    return binary_or(*l, *r);
+  auto op = [](auto x, auto y) { return x | y; };
+  return binary_eval<true, true>(lhs, rhs, op);
+}
+
+bitmap binary_xor(bitmap const& lhs, bitmap const& rhs) {
+  auto l = get_if<ewah_bitmap>(lhs);
+  auto r = get_if<ewah_bitmap>(rhs);
+  if (l && r)
+    return binary_xor(*l, *r);
+  auto op = [](auto x, auto y) { return x ^ y; };
+  return binary_eval<true, true>(lhs, rhs, op);
+}
+
+bitmap binary_nand(bitmap const& lhs, bitmap const& rhs) {
+  auto l = get_if<ewah_bitmap>(lhs);
+  auto r = get_if<ewah_bitmap>(rhs);
+  if (l && r)
+    return binary_nand(*l, *r);
+  auto op = [](auto x, auto y) { return x & ~y; };
+  return binary_eval<true, false>(lhs, rhs, op);
+}
+
+bitmap chain_eval(bitmap const& x, bitwise_chain<bitmap> const& ys) {
+  auto first = get_if<ewah_bitmap>(x);
+  if (first) {
+    bitwise_chain<ewah_bitmap> ewah_ys;
+    ewah_ys.reserve(ys.size());
+    for (auto& y : ys) {
+      auto bm = get_if<ewah_bitmap>(*y.second);
+      if (!bm)
+        break;
+      ewah_ys.emplace_back(y.first, bm);
+    }
+    if (ewah_ys.size() == ys.size())
+      return chain_eval(*first, ewah_ys);
+  }
+  return chain_eval<bitmap>(x, ys);
+}
+
+template <bool Bit>
+bitmap::size_type rank(bitmap const& bm, bitmap::size_type i) {
+  return visit([=](auto& x) { return rank<Bit>(x, i); }, bm);
+}
+
+template bitmap::size_type rank<true>(bitmap const& bm, bitmap::size_type i);
+
+template bitmap::size_type rank<false>(bitmap const& bm, bitmap::size_type i);
+
+template <bool Bit>
+bitmap::size_type select(bitmap const& bm, bitmap::size_type i) {
+  return visit([=](auto& x) { return select<Bit>(x, i); }, bm);
+}
+
+template bitmap::size_type select<true>(bitmap const& bm, bitmap::size_type i);
+
+template bitmap::size_type select<false>(bitmap const& bm, bitmap::size_type i);
+
+bitmap_skip_index::bitmap_skip_index(bitmap const& bm) : bm_{&bm} {
+  if (auto x = get_if<ewah_bitmap>(bm))
+    ewah_ = std::make_unique<ewah_skip_index>(*x);
+}
+
+template <bool Bit>
+bitmap_skip_index::size_type bitmap_skip_index::rank(size_type i) const {
+  return ewah_ ? ewah_->rank<Bit>(i) : vast::rank<Bit>(*bm_, i);
+}
+
+template <bool Bit>
+bitmap_skip_index::size_type bitmap_skip_index::rank() const {
+  return ewah_ ? ewah_->rank<Bit>() : vast::rank<Bit>(*bm_);
+}
+
+template <bool Bit>
+bitmap_skip_index::size_type bitmap_skip_index::select(size_type i) const {
+  return ewah_ ? ewah_->select<Bit>(i) : vast::select<Bit>(*bm_, i);
+}
+
+bitmap_skip_index::size_type bitmap_skip_index::find_next(size_type i) const {
+  if (ewah_)
+    return ewah_->find_next(i);
+  auto n = size_type{0};
+  for (auto b : bit_range(*bm_)) {
+    if (i == word_type::npos || i < n) {
+      auto first = find_first(b);
+      if (first != word_type::npos)
+        return n + first;
+    } else if (i < n + b.size()) {
+      auto next = vast::find_next(b, i - n);
+      if (next != word_type::npos)
+        return n + next;
+    }
+    n += b.size();
+  }
+  return word_type::npos;
+}
+
+template bitmap_skip_index::size_type
+bitmap_skip_index::rank<true>(size_type i) const;
+
+template bitmap_skip_index::size_type
+bitmap_skip_index::rank<false>(size_type i) const;
+
+template bitmap_skip_index::size_type bitmap_skip_index::rank<true>() const;
+
+template bitmap_skip_index::size_type bitmap_skip_index::rank<false>() const;
+
+template bitmap_skip_index::size_type
+bitmap_skip_index::select<true>(size_type i) const;
+
+template bitmap_skip_index::size_type
+bitmap_skip_index::select<false>(size_type i) const;
+
 } // namespace vast
@@ -0,0 +1,472 @@
+#include <algorithm>
+#include <functional>
+
+#include "vast/checker.hpp"
+#include "vast/event.hpp"
+#include "vast/type.hpp"
+
+namespace vast {
+
+namespace {
+
+using check = std::function<bool(event const&)>;
+
+using comparison = std::function<bool(data const&)>;
+
+using batch_check = std::function<void(event const*, size_t, uint8_t*)>;
+
+// Compares a column of operands, where a null pointer denotes a missing one.
+using kernel = std::function<void(data const* const*, size_t, uint8_t*)>;
+
+bool never(event const&) {
+  return false;
+}
+
+// Compares data of the expected type directly and leaves all other cases to
+// the generic evaluation, which preserves the semantics of ::evaluate.
+template <class T, class Compare>
+comparison make_comparison(T const& x, relational_operator op,
+                           data const& rhs) {
+  return [=](data const& lhs) {
+    if (auto y = get_if<T>(lhs))
+      return Compare{}(*y, x);
+    return evaluate(lhs, op, rhs);
+  };
+}
+
+// Selects a comparison function based on the operator and the type of the
+// RHS of a predicate.
+struct comparison_factory {
+  template <class T>
+  comparison operator()(T const& x) const {
+    return relational(x);
+  }
+
+  comparison operator()(none) const {
+    return generic();
+  }
+
+  comparison operator()(std::string const& x) const {
+    if (op == ni || op == not_ni) {
+      auto negate = op == not_ni;
+      auto o = op;
+      auto r = rhs;
+      return [=](data const& lhs) {
+        if (auto y = get_if<std::string>(lhs))
+          return (y->find(x) != std::string::npos) != negate;
+        return evaluate(lhs, o, r);
+      };
+    }
+    return relational(x);
+  }
+
+  comparison operator()(pattern const& x) const {
+    if (op == match || op == not_match || op == in || op == not_in) {
+      auto negate = op == not_match || op == not_in;
+      auto search = op == in || op == not_in;
+      auto o = op;
+      auto r = rhs;
+      return [=](data const& lhs) {
+        if (auto y = get_if<std::string>(lhs))
+          return (search ? x.search(*y) : x.match(*y)) != negate;
+        return evaluate(lhs, o, r);
+      };
+    }
+    return relational(x);
+  }
+
+  comparison operator()(subnet const& x) const {
+    if (op == in || op == not_in) {
+      auto negate = op == not_in;
+      auto o = op;
+      auto r = rhs;
+      return [=](data const& lhs) {
+        if (auto y = get_if<address>(lhs))
+          return x.contains(*y) != negate;
+        return evaluate(lhs, o, r);
+      };
+    }
+    return relational(x);
+  }
+
+  comparison operator()(set const& x) const {
+    // Sets are ordered, so membership costs a logarithmic lookup instead of
+    // the linear scan of the generic evaluation.
+    if (op == in || op == not_in) {
+      auto negate = op == not_in;
+      return [=](data const& lhs) {
+        return (x.count(lhs) > 0) != negate;
+      };
+    }
+    return relational(x);
+  }
+
+  template <class T>
+  comparison relational(T const& x) const {
+    switch (op) {
+      default:
+        return generic();
+      case equal:
+        return make_comparison<T, std::equal_to<T>>(x, op, rhs);
+      case not_equal:
+        return make_comparison<T, std::not_equal_to<T>>(x, op, rhs);
+      case less:
+        return make_comparison<T, std::less<T>>(x, op, rhs);
+      case less_equal:
+        return make_comparison<T, std::less_equal<T>>(x, op, rhs);
+      case greater:
+        return make_comparison<T, std::greater<T>>(x, op, rhs);
+      case greater_equal:
+        return make_comparison<T, std::greater_equal<T>>(x, op, rhs);
+    }
+  }
+
+  comparison generic() const {
+    auto o = op;
+    auto r = rhs;
+    return [=](data const& lhs) { return evaluate(lhs, o, r); };
+  }
+
+  relational_operator op;
+  data const& rhs;
+};
+
+// Compiles a tailored expression into a tree of closures.
+struct compiler {
+  check operator()(none) const {
+    return never;
+  }
+
+  check operator()(conjunction const& c) const {
+    std::vector<check> xs;
+    for (auto& op : c)
+      xs.push_back(visit(*this, op));
+    return [xs = std::move(xs)](event const& e) {
+      for (auto& x : xs)
+        if (!x(e))
+          return false;
+      return true;
+    };
+  }
+
+  check operator()(disjunction const& d) const {
+    std::vector<check> xs;
+    for (auto& op : d)
+      xs.push_back(visit(*this, op));
+    return [xs = std::move(xs)](event const& e) {
+      for (auto& x : xs)
+        if (x(e))
+          return true;
+      return false;
+    };
+  }
+
+  check operator()(negation const& n) const {
+    auto x = visit(*this, n.expr());
+    return [x = std::move(x)](event const& e) { return !x(e); };
+  }
+
+  check operator()(predicate const& p) const {
+    // Like the event_evaluator, we accept extractors on either side.
+    if (auto d = get_if<data>(p.lhs))
+      return is<data>(p.rhs) ? never : (*this)(predicate{p.rhs, p.op, *d});
+    auto d = get_if<data>(p.rhs);
+    if (!d)
+      return never;
+    auto cmp = visit(comparison_factory{p.op, *d}, *d);
+    if (auto a = get_if<attribute_extractor>(p.lhs)) {
+      // All events of the checker share the type, so the result is constant.
+      if (a->attr == "type") {
+        auto result = evaluate(type_.name(), p.op, *d);
+        return [=](event const&) { return result; };
+      }
+      if (a->attr == "time")
+        return [=](event const& e) { return cmp(e.timestamp()); };
+      return never;
+    }
+    if (auto x = get_if<data_extractor>(p.lhs)) {
+      if (x->type != type_)
+        return never;
+      if (x->offset.empty())
+        return [=](event const& e) { return cmp(e.data()); };
+      // Most extractors refer to a top-level field of a record.
+      if (x->offset.size() == 1) {
+        auto i = x->offset[0];
+        return [=](event const& e) {
+          auto r = get_if<vector>(e.data());
+          return r && i < r->size() && cmp((*r)[i]);
+        };
+      }
+      auto o = x->offset;
+      return [=](event const& e) {
+        auto r = get_if<vector>(e.data());
+        if (!r)
+          return false;
+        auto y = get(*r, o);
+        return y && cmp(*y);
+      };
+    }
+    return never;
+  }
+
+  type const& type_;
+};
+
+// Wraps a comparison function into a kernel that compares one operand at a
+// time. We use this for all operand types without a columnar representation.
+kernel make_scalar_kernel(comparison cmp) {
+  return [=](data const* const* xs, size_t n, uint8_t* out) {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = xs[i] && cmp(*xs[i]);
+  };
+}
+
+// Copies all operands of type T into a contiguous column and compares the
+// column in a loop that the compiler can vectorize. Operands of other types
+// go through the generic evaluation afterwards.
+template <class T, class Compare, class Project>
+kernel make_column_kernel(T const& x, relational_operator op, data const& rhs,
+                          Project f) {
+  using column_type = decltype(f(x));
+  auto y = f(x);
+  return [=](data const* const* xs, size_t n, uint8_t* out) {
+    std::vector<column_type> column(n);
+    std::vector<size_t> others;
+    for (size_t i = 0; i < n; ++i) {
+      auto z = xs[i] ? get_if<T>(*xs[i]) : nullptr;
+      if (z)
+        column[i] = f(*z);
+      else
+        others.push_back(i);
+    }
+    Compare cmp;
+    for (size_t i = 0; i < n; ++i)
+      out[i] = cmp(column[i], y);
+    for (auto i : others)
+      out[i] = xs[i] && evaluate(*xs[i], op, rhs);
+  };
+}
+
+struct identity {
+  template <class T>
+  T operator()(T const& x) const {
+    return x;
+  }
+};
+
+// Selects a kernel based on the operator and the type of the RHS of a
+// predicate.
+struct kernel_factory {
+  template <class T>
+  kernel operator()(T const&) const {
+    return make_scalar_kernel(visit(comparison_factory{op, rhs}, rhs));
+  }
+
+  // We avoid std::vector<bool> for the column.
+  kernel operator()(boolean x) const {
+    return column(x, [](boolean y) { return static_cast<uint8_t>(y); });
+  }
+
+  kernel operator()(integer x) const {
+    return column(x, identity{});
+  }
+
+  kernel operator()(count x) const {
+    return column(x, identity{});
+  }
+
+  kernel operator()(real x) const {
+    return column(x, identity{});
+  }
+
+  kernel operator()(enumeration x) const {
+    return column(x, identity{});
+  }
+
+  kernel operator()(timespan x) const {
+    return column(x, [](timespan y) { return y.count(); });
+  }
+
+  kernel operator()(timestamp x) const {
+    return column(x, [](timestamp y) { return y.time_since_epoch().count(); });
+  }
+
+  kernel operator()(address const& x) const {
+    return column(x, identity{});
+  }
+
+  kernel operator()(port const& x) const {
+    return column(x, identity{});
+  }
+
+  template <class T, class Project>
+  kernel column(T const& x, Project f) const {
+    switch (op) {
+      default:
+        return make_scalar_kernel(visit(comparison_factory{op, rhs}, rhs));
+      case equal:
+        return make_column_kernel<T, std::equal_to<>>(x, op, rhs, f);
+      case not_equal:
+        return make_column_kernel<T, std::not_equal_to<>>(x, op, rhs, f);
+      case less:
+        return make_column_kernel<T, std::less<>>(x, op, rhs, f);
+      case less_equal:
+        return make_column_kernel<T, std::less_equal<>>(x, op, rhs, f);
+      case greater:
+        return make_column_kernel<T, std::greater<>>(x, op, rhs, f);
+      case greater_equal:
+        return make_column_kernel<T, std::greater_equal<>>(x, op, rhs, f);
+    }
+  }
+
+  relational_operator op;
+  data const& rhs;
+};
+
+// Compiles a tailored expression into a tree of closures that each process a
+// whole batch of events.
+struct batch_compiler {
+  batch_check operator()(none) const {
+    return [](event const*, size_t n, uint8_t* out) {
+      std::fill_n(out, n, 0);
+    };
+  }
+
+  batch_check operator()(conjunction const& c) const {
+    std::vector<batch_check> xs;
+    for (auto& op : c)
+      xs.push_back(visit(*this, op));
+    return [xs = std::move(xs)](event const* es, size_t n, uint8_t* out) {
+      xs[0](es, n, out);
+      std::vector<uint8_t> tmp(n);
+      for (size_t k = 1; k < xs.size(); ++k) {
+        if (std::none_of(out, out + n, [](uint8_t x) { return x != 0; }))
+          return;
+        xs[k](es, n, tmp.data());
+        for (size_t i = 0; i < n; ++i)
+          out[i] &= tmp[i];
+      }
+    };
+  }
+
+  batch_check operator()(disjunction const& d) const {
+    std::vector<batch_check> xs;
+    for (auto& op : d)
+      xs.push_back(visit(*this, op));
+    return [xs = std::move(xs)](event const* es, size_t n, uint8_t* out) {
+      xs[0](es, n, out);
+      std::vector<uint8_t> tmp(n);
+      for (size_t k = 1; k < xs.size(); ++k) {
+        if (std::all_of(out, out + n, [](uint8_t x) { return x != 0; }))
+          return;
+        xs[k](es, n, tmp.data());
+        for (size_t i = 0; i < n; ++i)
+          out[i] |= tmp[i];
+      }
+    };
+  }
+
+  batch_check operator()(negation const& neg) const {
+    auto x = visit(*this, neg.expr());
+    return [x = std::move(x)](event const* es, size_t n, uint8_t* out) {
+      x(es, n, out);
+      for (size_t i = 0; i < n; ++i)
+        out[i] ^= 1;
+    };
+  }
+
+  batch_check operator()(predicate const& p) const {
+    if (auto d = get_if<data>(p.lhs)) {
+      if (is<data>(p.rhs))
+        return (*this)(none{});
+      return (*this)(predicate{p.rhs, p.op, *d});
+    }
+    auto d = get_if<data>(p.rhs);
+    if (!d)
+      return (*this)(none{});
+    auto k = visit(kernel_factory{p.op, *d}, *d);
+    if (auto a = get_if<attribute_extractor>(p.lhs)) {
+      if (a->attr == "type") {
+        auto result = static_cast<uint8_t>(evaluate(type_.name(), p.op, *d));
+        return [=](event const*, size_t n, uint8_t* out) {
+          std::fill_n(out, n, result);
+        };
+      }
+      if (a->attr == "time")
+        return [=](event const* es, size_t n, uint8_t* out) {
+          std::vector<data> times(n);
+          std::vector<data const*> xs(n);
+          for (size_t i = 0; i < n; ++i) {
+            times[i] = es[i].timestamp();
+            xs[i] = &times[i];
+          }
+          k(xs.data(), n, out);
+        };
+      return (*this)(none{});
+    }
+    if (auto x = get_if<data_extractor>(p.lhs)) {
+      if (x->type != type_)
+        return (*this)(none{});
+      auto o = x->offset;
+      return [=](event const* es, size_t n, uint8_t* out) {
+        // Extract the operand of all events first, so that the kernel runs
+        // over a column.
+        std::vector<data const*> xs(n);
+        if (o.empty()) {
+          for (size_t i = 0; i < n; ++i)
+            xs[i] = &es[i].data();
+        } else if (o.size() == 1) {
+          auto j = o[0];
+          for (size_t i = 0; i < n; ++i) {
+            auto r = get_if<vector>(es[i].data());
+            xs[i] = r && j < r->size() ? &(*r)[j] : nullptr;
+          }
+        } else {
+          for (size_t i = 0; i < n; ++i) {
+            auto r = get_if<vector>(es[i].data());
+            xs[i] = r ? get(*r, o) : nullptr;
+          }
+        }
+        k(xs.data(), n, out);
+      };
+    }
+    return (*this)(none{});
+  }
+
+  type const& type_;
+};
+
+} // namespace <anonymous>
+
+bool checker::operator()(event const& e) const {
+  return check_ && check_(e);
+}
+
+void checker::operator()(event const* xs, size_t n,
+                         std::vector<uint8_t>& result) const {
+  auto first = result.size();
+  result.resize(first + n);
+  if (check_batch_)
+    check_batch_(xs, n, result.data() + first);
+}
+
+expression const& checker::expr() const {
+  return expr_;
+}
+
+checker::operator bool() const {
+  return static_cast<bool>(check_);
+}
+
+expected<checker> make_checker(expression const& expr, type const& t) {
+  auto x = tailor(expr, t);
+  if (!x)
+    return x.error();
+  checker result;
+  result.check_ = visit(compiler{t}, *x);
+  result.check_batch_ = visit(batch_compiler{t}, *x);
+  result.expr_ = std::move(*x);
+  return result;
+}
+
+} // namespace vast
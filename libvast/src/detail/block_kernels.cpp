@@ -0,0 +1,242 @@
+#include "vast/detail/block_kernels.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#  define VAST_BLOCK_KERNELS_X86
+#  include <immintrin.h>
+#endif
+
+namespace vast {
+namespace detail {
+namespace {
+
+using binary_kernel = void (*)(uint64_t*, uint64_t const*, uint64_t const*,
+                               size_t);
+
+using popcount_kernel = uint64_t (*)(uint64_t const*, size_t);
+
+struct kernel_table {
+  binary_kernel and_blocks;
+  binary_kernel or_blocks;
+  binary_kernel xor_blocks;
+  binary_kernel and_not_blocks;
+  popcount_kernel popcount_blocks;
+  char const* isa;
+};
+
+// -- scalar ------------------------------------------------------------------
+
+struct and_op {
+  static uint64_t apply(uint64_t x, uint64_t y) {
+    return x & y;
+  }
+#ifdef VAST_BLOCK_KERNELS_X86
+  __attribute__((target("avx2")))
+  static __m256i apply(__m256i x, __m256i y) {
+    return _mm256_and_si256(x, y);
+  }
+  __attribute__((target("avx512f")))
+  static __m512i apply(__m512i x, __m512i y) {
+    return _mm512_and_si512(x, y);
+  }
+#endif
+};
+
+struct or_op {
+  static uint64_t apply(uint64_t x, uint64_t y) {
+    return x | y;
+  }
+#ifdef VAST_BLOCK_KERNELS_X86
+  __attribute__((target("avx2")))
+  static __m256i apply(__m256i x, __m256i y) {
+    return _mm256_or_si256(x, y);
+  }
+  __attribute__((target("avx512f")))
+  static __m512i apply(__m512i x, __m512i y) {
+    return _mm512_or_si512(x, y);
+  }
+#endif
+};
+
+struct xor_op {
+  static uint64_t apply(uint64_t x, uint64_t y) {
+    return x ^ y;
+  }
+#ifdef VAST_BLOCK_KERNELS_X86
+  __attribute__((target("avx2")))
+  static __m256i apply(__m256i x, __m256i y) {
+    return _mm256_xor_si256(x, y);
+  }
+  __attribute__((target("avx512f")))
+  static __m512i apply(__m512i x, __m512i y) {
+    return _mm512_xor_si512(x, y);
+  }
+#endif
+};
+
+struct and_not_op {
+  static uint64_t apply(uint64_t x, uint64_t y) {
+    return x & ~y;
+  }
+#ifdef VAST_BLOCK_KERNELS_X86
+  // Note the swapped argument order of the intrinsics: they compute ~a & b.
+  __attribute__((target("avx2")))
+  static __m256i apply(__m256i x, __m256i y) {
+    return _mm256_andnot_si256(y, x);
+  }
+  __attribute__((target("avx512f")))
+  static __m512i apply(__m512i x, __m512i y) {
+    return _mm512_andnot_si512(y, x);
+  }
+#endif
+};
+
+template <class Op>
+void scalar_binary(uint64_t* dst, uint64_t const* x, uint64_t const* y,
+                   size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = Op::apply(x[i], y[i]);
+}
+
+uint64_t scalar_popcount(uint64_t const* xs, size_t n) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < n; ++i)
+    result += __builtin_popcountll(xs[i]);
+  return result;
+}
+
+#ifdef VAST_BLOCK_KERNELS_X86
+
+// -- AVX2 --------------------------------------------------------------------
+
+template <class Op>
+__attribute__((target("avx2")))
+void avx2_binary(uint64_t* dst, uint64_t const* x, uint64_t const* y,
+                 size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto a = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(x + i));
+    auto b = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(y + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), Op::apply(a, b));
+  }
+  scalar_binary<Op>(dst + i, x + i, y + i, n - i);
+}
+
+// Counts bits per nibble with a shuffle-based lookup table and sums up the
+// byte counts horizontally (Mula, Kurz, and Lemire, 2016).
+__attribute__((target("avx2")))
+uint64_t avx2_popcount(uint64_t const* xs, size_t n) {
+  auto lookup = _mm256_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  auto low_mask = _mm256_set1_epi8(0x0f);
+  auto acc = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(xs + i));
+    auto lo = _mm256_and_si256(v, low_mask);
+    auto hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    auto cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                               _mm256_shuffle_epi8(lookup, hi));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+  }
+  uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+    + scalar_popcount(xs + i, n - i);
+}
+
+// -- AVX-512 -----------------------------------------------------------------
+
+template <class Op>
+__attribute__((target("avx512f")))
+void avx512_binary(uint64_t* dst, uint64_t const* x, uint64_t const* y,
+                   size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    auto a = _mm512_loadu_si512(x + i);
+    auto b = _mm512_loadu_si512(y + i);
+    _mm512_storeu_si512(dst + i, Op::apply(a, b));
+  }
+  scalar_binary<Op>(dst + i, x + i, y + i, n - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+uint64_t avx512_popcount(uint64_t const* xs, size_t n) {
+  // The same nibble lookup table as above, replicated across all lanes.
+  auto lo_table = 0x0302020102010100ll;
+  auto hi_table = 0x0403030203020201ll;
+  auto lookup = _mm512_set_epi64(hi_table, lo_table, hi_table, lo_table,
+                                 hi_table, lo_table, hi_table, lo_table);
+  auto low_mask = _mm512_set1_epi8(0x0f);
+  auto acc = _mm512_setzero_si512();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    auto v = _mm512_loadu_si512(xs + i);
+    auto lo = _mm512_and_si512(v, low_mask);
+    auto hi = _mm512_and_si512(_mm512_srli_epi16(v, 4), low_mask);
+    auto cnt = _mm512_add_epi8(_mm512_shuffle_epi8(lookup, lo),
+                               _mm512_shuffle_epi8(lookup, hi));
+    acc = _mm512_add_epi64(acc, _mm512_sad_epu8(cnt, _mm512_setzero_si512()));
+  }
+  uint64_t lanes[8];
+  _mm512_storeu_si512(lanes, acc);
+  auto result = scalar_popcount(xs + i, n - i);
+  for (auto lane : lanes)
+    result += lane;
+  return result;
+}
+
+#endif // VAST_BLOCK_KERNELS_X86
+
+kernel_table make_kernel_table() {
+#ifdef VAST_BLOCK_KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    return {avx512_binary<and_op>, avx512_binary<or_op>,
+            avx512_binary<xor_op>, avx512_binary<and_not_op>,
+            avx512_popcount, "avx512"};
+  if (__builtin_cpu_supports("avx2"))
+    return {avx2_binary<and_op>, avx2_binary<or_op>, avx2_binary<xor_op>,
+            avx2_binary<and_not_op>, avx2_popcount, "avx2"};
+#endif
+  return {scalar_binary<and_op>, scalar_binary<or_op>, scalar_binary<xor_op>,
+          scalar_binary<and_not_op>, scalar_popcount, "scalar"};
+}
+
+kernel_table const& kernels() {
+  static auto const table = make_kernel_table();
+  return table;
+}
+
+} // namespace <anonymous>
+
+void and_blocks(uint64_t* dst, uint64_t const* x, uint64_t const* y,
+                size_t n) {
+  kernels().and_blocks(dst, x, y, n);
+}
+
+void or_blocks(uint64_t* dst, uint64_t const* x, uint64_t const* y,
+               size_t n) {
+  kernels().or_blocks(dst, x, y, n);
+}
+
+void xor_blocks(uint64_t* dst, uint64_t const* x, uint64_t const* y,
+                size_t n) {
+  kernels().xor_blocks(dst, x, y, n);
+}
+
+void and_not_blocks(uint64_t* dst, uint64_t const* x, uint64_t const* y,
+                    size_t n) {
+  kernels().and_not_blocks(dst, x, y, n);
+}
+
+uint64_t popcount_blocks(uint64_t const* xs, size_t n) {
+  return kernels().popcount_blocks(xs, n);
+}
+
+char const* block_kernels_isa() {
+  return kernels().isa;
+}
+
+} // namespace detail
+} // namespace vast
@@ -0,0 +1,115 @@
+#include <cstring>
+
+#include "vast/detail/assert.hpp"
+#include "vast/detail/chunked_line_range.hpp"
+
+namespace vast {
+namespace detail {
+
+constexpr size_t chunked_line_range::default_chunk_size;
+
+chunked_line_range::chunked_line_range(std::istream& input, size_t chunk_size)
+  : input_{input},
+    chunk_(chunk_size > 0 ? chunk_size : default_chunk_size) {
+  next(); // prime the pump
+}
+
+std::string const& chunked_line_range::get() const {
+  if (!copied_) {
+    copy_.assign(line_.first, line_.second);
+    copied_ = true;
+  }
+  return copy_;
+}
+
+chunked_line_range::view_type chunked_line_range::view() const {
+  return line_;
+}
+
+void chunked_line_range::next() {
+  VAST_ASSERT(!done());
+  if (!advance(true)) {
+    line_ = {nullptr, nullptr};
+    copied_ = false;
+    done_ = true;
+  }
+}
+
+bool chunked_line_range::next_buffered() {
+  VAST_ASSERT(!done());
+  return advance(false);
+}
+
+bool chunked_line_range::ready() const {
+  if (done_ || eof_)
+    return true;
+  auto first = chunk_.data() + pos_;
+  if (std::memchr(first, '\n', size_ - pos_) != nullptr)
+    return true;
+  return input_.rdbuf()->in_avail() != 0;
+}
+
+bool chunked_line_range::done() const {
+  return done_;
+}
+
+size_t chunked_line_range::line_number() const {
+  return line_number_;
+}
+
+bool chunked_line_range::advance(bool refill) {
+  // Get the next non-empty line.
+  while (true) {
+    auto first = chunk_.data() + pos_;
+    auto last = chunk_.data() + size_;
+    auto nl = static_cast<char const*>(std::memchr(first, '\n', last - first));
+    if (nl == nullptr && eof_ && first != last)
+      nl = last; // The final line lacks a line break.
+    if (nl != nullptr) {
+      ++line_number_;
+      pos_ = nl - chunk_.data() + (nl != last);
+      if (nl == first)
+        continue;
+      line_ = {first, nl};
+      copied_ = false;
+      return true;
+    }
+    if (eof_ || !refill || !this->refill())
+      return false;
+  }
+}
+
+bool chunked_line_range::refill() {
+  VAST_ASSERT(!eof_);
+  // Move the incomplete line at the end of the chunk to the front, and grow
+  // the chunk if that line spans the entire chunk.
+  auto tail = size_ - pos_;
+  if (tail > 0 && pos_ > 0)
+    std::memmove(chunk_.data(), chunk_.data() + pos_, tail);
+  if (tail == chunk_.size())
+    chunk_.resize(2 * chunk_.size());
+  line_ = {nullptr, nullptr};
+  pos_ = 0;
+  size_ = tail;
+  // Block until input arrives, then take everything the stream delivers
+  // without blocking. For files, this fills the entire chunk. For pipes and
+  // sockets, we hand out the lines that arrived so far instead of waiting
+  // until they fill a chunk.
+  auto first = chunk_.data() + size_;
+  auto room = chunk_.size() - size_;
+  size_t n = 0;
+  if (input_.peek() != std::istream::traits_type::eof())
+    while (n < room) {
+      auto k = input_.readsome(first + n, room - n);
+      if (k <= 0)
+        break;
+      n += static_cast<size_t>(k);
+    }
+  size_ += n;
+  if (!input_.good())
+    eof_ = true;
+  return n > 0 || (eof_ && size_ > 0);
+}
+
+} // namespace detail
+} // namespace vast
@@ -1,5 +1,9 @@
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 
@@ -13,6 +17,15 @@ fdinbuf::fdinbuf(int fd, size_t buffer_size)
   : fd_{fd},
     buffer_(buffer_size) {
   VAST_ASSERT(buffer_size > putback_area_size);
+#ifdef F_SETPIPE_SZ
+  // A pipe holds only 64 KB by default, which caps how much input a reader
+  // can take at once without blocking. We ask for more so that a producer
+  // that runs ahead of us leaves large blocks behind. This is best effort:
+  // the kernel caps the size for unprivileged processes.
+  struct stat st;
+  if (::fstat(fd_, &st) == 0 && S_ISFIFO(st.st_mode))
+    ::fcntl(fd_, F_SETPIPE_SZ, 1 << 20);
+#endif
   setg(buffer_.data() + putback_area_size,  // beginning of putback area
        buffer_.data() + putback_area_size,  // read position
        buffer_.data() + putback_area_size); // end position
@@ -55,5 +68,48 @@ fdinbuf::int_type fdinbuf::underflow() {
   return traits_type::to_int_type(*gptr());
 }
 
+std::streamsize fdinbuf::showmanyc() {
+  int n;
+  if (::ioctl(fd_, FIONREAD, &n) < 0)
+    return 0;
+  return n;
+}
+
+std::streamsize fdinbuf::xsgetn(char_type* s, std::streamsize n) {
+  // Hand out the buffered characters first.
+  auto buffered = std::min(n, static_cast<std::streamsize>(egptr() - gptr()));
+  std::memcpy(s, gptr(), buffered);
+  gbump(static_cast<int>(buffered));
+  auto got = buffered;
+  auto capacity = static_cast<std::streamsize>(buffer_.size()
+                                               - putback_area_size);
+  while (got < n) {
+    if (n - got < capacity) {
+      // Small requests go through the buffer.
+      if (traits_type::eq_int_type(underflow(), traits_type::eof()))
+        break;
+      auto k = std::min(n - got, static_cast<std::streamsize>(egptr()
+                                                              - gptr()));
+      std::memcpy(s + got, gptr(), k);
+      gbump(static_cast<int>(k));
+      got += k;
+      continue;
+    }
+    auto k = ::read(fd_, s + got, n - got);
+    if (k <= 0)
+      break;
+    got += k;
+    // Keep the tail of the read as putback area.
+    auto num_putback = std::min(got, static_cast<std::streamsize>(
+                                       putback_area_size));
+    std::memcpy(buffer_.data() + (putback_area_size - num_putback),
+                s + got - num_putback, num_putback);
+    setg(buffer_.data() + (putback_area_size - num_putback),
+         buffer_.data() + putback_area_size,
+         buffer_.data() + putback_area_size);
+  }
+  return got;
+}
+
 } // namespace detail
 } // namespace vast
@@ -1,5 +1,6 @@
 #include <unistd.h>
 
+#include <cerrno>
 #include <cstdio>
 
 #include "vast/detail/fdoutbuf.hpp"
@@ -20,7 +21,19 @@ fdoutbuf::int_type fdoutbuf::overflow(int_type c) {
 }
 
 std::streamsize fdoutbuf::xsputn(char const* s, std::streamsize n) {
-  return ::write(fd_, s, n);
+  // Pipes and sockets may accept only part of a large write, so we keep
+  // writing until the entire chunk is out.
+  std::streamsize written = 0;
+  while (written < n) {
+    auto r = ::write(fd_, s + written, n - written);
+    if (r < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    written += r;
+  }
+  return written;
 }
 
 } // namespace detail
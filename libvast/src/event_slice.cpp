@@ -0,0 +1,85 @@
+#include <algorithm>
+
+#include <caf/deserializer.hpp>
+#include <caf/serializer.hpp>
+
+#include "vast/event_slice.hpp"
+
+namespace vast {
+
+std::vector<event> const event_slice::empty_events;
+std::vector<type> const event_slice::empty_types;
+
+event_slice::event_slice(std::vector<event> xs) {
+  if (xs.empty())
+    return;
+  auto x = std::make_shared<impl>();
+  x->events = std::move(xs);
+  // Events typically arrive in runs of the same type, so we only search the
+  // (short) list of known types when the type changes.
+  type const* prev = nullptr;
+  for (auto& e : x->events) {
+    if (prev && e.type() == *prev)
+      continue;
+    auto i = std::find(x->types.begin(), x->types.end(), e.type());
+    if (i == x->types.end()) {
+      x->types.push_back(e.type());
+      prev = &x->types.back();
+    } else {
+      prev = &*i;
+    }
+  }
+  ptr_ = std::move(x);
+}
+
+event_id event_slice::first_id() const {
+  return empty() ? invalid_event_id : front().id();
+}
+
+event_id event_slice::last_id() const {
+  return empty() ? invalid_event_id : back().id() + 1;
+}
+
+std::vector<type> const& event_slice::types() const {
+  return ptr_ ? ptr_->types : empty_types;
+}
+
+std::vector<event> const& event_slice::events() const {
+  return ptr_ ? ptr_->events : empty_events;
+}
+
+event_slice::const_iterator event_slice::begin() const {
+  return events().begin();
+}
+
+event_slice::const_iterator event_slice::end() const {
+  return events().end();
+}
+
+event const& event_slice::front() const {
+  return events().front();
+}
+
+event const& event_slice::back() const {
+  return events().back();
+}
+
+event_slice::size_type event_slice::size() const {
+  return events().size();
+}
+
+bool event_slice::empty() const {
+  return events().empty();
+}
+
+void serialize(caf::serializer& sink, event_slice const& x) {
+  sink & x.events();
+}
+
+void serialize(caf::deserializer& source, event_slice& x) {
+  std::vector<event> xs;
+  source & xs;
+  x = event_slice{std::move(xs)};
+}
+
+} // namespace vast
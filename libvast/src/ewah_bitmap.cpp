@@ -1,4 +1,10 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+
 #include "vast/ewah_bitmap.hpp"
+#include "vast/detail/block_kernels.hpp"
 
 namespace vast {
 
@@ -152,7 +158,8 @@ void ewah_bitmap::flip() {
   }
   // Only flip the active bits in the last block.
   auto partial = num_bits_ % word_type::width;
-  blocks_.back() ^= word_type::lsb_mask(partial);
+  blocks_.back() ^=
+    partial == 0 ? word_type::all : word_type::lsb_mask(partial);
 }
 
 void ewah_bitmap::integrate_last_block() {
@@ -280,4 +287,611 @@ ewah_bitmap_range bit_range(ewah_bitmap const& bm) {
   return ewah_bitmap_range{bm};
 }
 
+namespace {
+
+using block_type = ewah_bitmap::block_type;
+using size_type = ewah_bitmap::size_type;
+using word_type = ewah_bitmap::word_type;
+
+// Iterates over the words of an EWAH bitmap in terms of runs, where a run is
+// either a sequence of clean words of the same type or a contiguous sequence
+// of dirty words. The trailing (possibly partial) block constitutes a dirty
+// run of length 1.
+class word_cursor {
+public:
+  explicit word_cursor(ewah_bitmap const& bm)
+    : blocks_{bm.blocks().data()},
+      size_{bm.blocks().size()} {
+    load();
+  }
+
+  // Restores a cursor from a previously obtained origin and offset.
+  word_cursor(ewah_bitmap const& bm, size_type origin, size_type offset)
+    : blocks_{bm.blocks().data()},
+      size_{bm.blocks().size()},
+      next_{origin} {
+    load();
+    while (offset > 0) {
+      auto n = std::min(offset, words());
+      advance(n);
+      offset -= n;
+    }
+  }
+
+  bool done() const {
+    return clean_ == 0 && dirty_ == 0;
+  }
+
+  bool clean() const {
+    return clean_ > 0;
+  }
+
+  // Retrieves the number of words remaining in the current run.
+  size_type words() const {
+    return clean_ > 0 ? clean_ : dirty_;
+  }
+
+  // Retrieves the value of the current clean run.
+  block_type fill() const {
+    return fill_;
+  }
+
+  // Retrieves a pointer to the current dirty words.
+  block_type const* dirty() const {
+    return dirty_words_;
+  }
+
+  // Retrieves the current word.
+  block_type get() const {
+    return clean_ > 0 ? fill_ : *dirty_words_;
+  }
+
+  // Retrieves the index of the block from which the cursor loaded the
+  // current run(s).
+  size_type origin() const {
+    return origin_;
+  }
+
+  // Retrieves the number of words the cursor advanced since the last load.
+  size_type offset() const {
+    return offset_;
+  }
+
+  // Advances the cursor by *n* words within the current run.
+  // @pre `n <= words()`
+  void advance(size_type n) {
+    VAST_ASSERT(n <= words());
+    offset_ += n;
+    if (clean_ > 0) {
+      clean_ -= n;
+    } else {
+      dirty_ -= n;
+      dirty_words_ += n;
+    }
+    if (clean_ == 0 && dirty_ == 0)
+      load();
+  }
+
+private:
+  void load() {
+    origin_ = next_;
+    offset_ = 0;
+    while (next_ < size_) {
+      origin_ = next_;
+      if (next_ + 1 == size_) {
+        // The last block; always dirty.
+        dirty_ = 1;
+        dirty_words_ = blocks_ + next_++;
+        return;
+      }
+      auto marker = blocks_[next_];
+      clean_ = word_type::marker_num_clean(marker);
+      fill_ = word_type::marker_type(marker) ? word_type::all : word_type::none;
+      dirty_ = word_type::marker_num_dirty(marker);
+      dirty_words_ = blocks_ + next_ + 1;
+      next_ += dirty_ + 1;
+      if (clean_ > 0 || dirty_ > 0)
+        return;
+    }
+  }
+
+  block_type const* blocks_;
+  size_type size_;
+  size_type next_ = 0;
+  size_type origin_ = 0;
+  size_type offset_ = 0;
+  size_type clean_ = 0;
+  size_type dirty_ = 0;
+  block_type fill_ = 0;
+  block_type const* dirty_words_ = nullptr;
+};
+
+// Appends the bits in *[pos,size)* of the bitmap that *cursor* traverses,
+// where the cursor currently points to the word beginning at bit *pos*.
+void append_tail(ewah_bitmap& result, word_cursor& cursor, size_type pos,
+                 size_type size) {
+  VAST_ASSERT(pos % word_type::width == 0 || pos >= size);
+  while (pos < size) {
+    if (cursor.clean()) {
+      auto n = cursor.words() * word_type::width;
+      result.append_bits(cursor.fill() != 0, n);
+      cursor.advance(cursor.words());
+      pos += n;
+    } else {
+      auto n = std::min(word_type::width, size - pos);
+      result.append_block(cursor.get(), n);
+      cursor.advance(1);
+      pos += n;
+    }
+  }
+}
+
+// Evaluates a bitwise operation over two EWAH bitmaps run by run, applying
+// the block kernel to overlapping runs of dirty words. The fill flags have
+// the same semantics as in binary_eval.
+template <class Kernel, class Operation>
+ewah_bitmap eval(ewah_bitmap const& lhs, ewah_bitmap const& rhs,
+                 Kernel kernel, Operation op, bool fill_lhs, bool fill_rhs) {
+  ewah_bitmap result;
+  auto min_size = std::min(lhs.size(), rhs.size());
+  auto max_size = std::max(lhs.size(), rhs.size());
+  auto remaining = min_size / word_type::width;
+  word_cursor l{lhs};
+  word_cursor r{rhs};
+  std::vector<block_type> buffer;
+  while (remaining > 0) {
+    auto n = std::min({l.words(), r.words(), remaining});
+    if (l.clean() && r.clean()) {
+      result.append_bits(op(l.fill(), r.fill()) != 0, n * word_type::width);
+    } else if (l.clean() || r.clean()) {
+      auto fill = l.clean() ? l.fill() : r.fill();
+      auto words = l.clean() ? r.dirty() : l.dirty();
+      auto apply = [&](auto x) {
+        return l.clean() ? op(fill, x) : op(x, fill);
+      };
+      // The clean run may render the dirty words irrelevant, e.g., when
+      // ANDing with 0s or ORing with 1s.
+      if (apply(word_type::none) == apply(word_type::all))
+        result.append_bits(apply(word_type::none) != 0, n * word_type::width);
+      else
+        for (auto i = 0u; i < n; ++i)
+          result.append_block(apply(words[i]));
+    } else {
+      buffer.resize(n);
+      kernel(buffer.data(), l.dirty(), r.dirty(), n);
+      for (auto block : buffer)
+        result.append_block(block);
+    }
+    l.advance(n);
+    r.advance(n);
+    remaining -= n;
+  }
+  // If the shorter bitmap ends within a word, we evaluate that word over the
+  // extent of the longer bitmap, treating missing bits as 0.
+  auto pos = result.size();
+  if (min_size % word_type::width > 0) {
+    auto valid = [&](auto& bm, auto& cursor) {
+      auto n = std::min(word_type::width, bm.size() - pos);
+      return cursor.get() & word_type::lsb_fill(n);
+    };
+    auto n = std::min(word_type::width, max_size - pos);
+    result.append_block(op(valid(lhs, l), valid(rhs, r)), n);
+    l.advance(1);
+    r.advance(1);
+    pos += n;
+  }
+  if (!fill_lhs && !fill_rhs)
+    result.append_bits(false, max_size - result.size());
+  else if (fill_lhs && lhs.size() > pos)
+    append_tail(result, l, pos, lhs.size());
+  else if (fill_rhs && rhs.size() > pos)
+    append_tail(result, r, pos, rhs.size());
+  return result;
+}
+
+// Applies a bitwise operator of a chain evaluation to two words.
+block_type apply(arithmetic_operator op, block_type x, block_type y) {
+  switch (op) {
+    default:
+      VAST_ASSERT(!"invalid bitwise operator");
+      return x;
+    case bitwise_and:
+      return x & y;
+    case bitwise_or:
+      return x | y;
+    case bitwise_xor:
+      return x ^ y;
+    case minus:
+      return x & ~y;
+  }
+}
+
+// Retrieves the block kernel for a bitwise operator of a chain evaluation.
+auto kernel(arithmetic_operator op) {
+  switch (op) {
+    default:
+      VAST_ASSERT(!"invalid bitwise operator");
+      return detail::and_blocks;
+    case bitwise_and:
+      return detail::and_blocks;
+    case bitwise_or:
+      return detail::or_blocks;
+    case bitwise_xor:
+      return detail::xor_blocks;
+    case minus:
+      return detail::and_not_blocks;
+  }
+}
+
+// An operand in a chain evaluation. In addition to the cursor, it keeps track
+// of the word interval *[first,last)* that the current run spans.
+struct chain_operand {
+  chain_operand(arithmetic_operator op, ewah_bitmap const& bm)
+    : op{op},
+      cursor{bm} {
+  }
+
+  bool clean() const {
+    return cursor.done() || cursor.clean();
+  }
+
+  block_type fill() const {
+    return cursor.done() ? word_type::none : cursor.fill();
+  }
+
+  // Retrieves a pointer to the dirty word at position *pos*.
+  block_type const* dirty(size_type pos) const {
+    VAST_ASSERT(!clean());
+    VAST_ASSERT(pos >= first && pos < last);
+    return cursor.dirty() + (pos - first);
+  }
+
+  // Retrieves the word at position *pos*.
+  block_type get(size_type pos) const {
+    return clean() ? fill() : *dirty(pos);
+  }
+
+  arithmetic_operator op;
+  word_cursor cursor;
+  size_type first = 0;
+  size_type last = 0;
+};
+
+} // namespace <anonymous>
+
+ewah_bitmap binary_and(ewah_bitmap const& lhs, ewah_bitmap const& rhs) {
+  auto op = [](auto x, auto y) { return x & y; };
+  return eval(lhs, rhs, detail::and_blocks, op, false, false);
+}
+
+ewah_bitmap binary_or(ewah_bitmap const& lhs, ewah_bitmap const& rhs) {
+  auto op = [](auto x, auto y) { return x | y; };
+  return eval(lhs, rhs, detail::or_blocks, op, true, true);
+}
+
+ewah_bitmap binary_xor(ewah_bitmap const& lhs, ewah_bitmap const& rhs) {
+  auto op = [](auto x, auto y) { return x ^ y; };
+  return eval(lhs, rhs, detail::xor_blocks, op, true, true);
+}
+
+ewah_bitmap binary_nand(ewah_bitmap const& lhs, ewah_bitmap const& rhs) {
+  auto op = [](auto x, auto y) { return x & ~y; };
+  return eval(lhs, rhs, detail::and_not_blocks, op, true, false);
+}
+
+ewah_bitmap chain_eval(ewah_bitmap const& x,
+                       bitwise_chain<ewah_bitmap> const& ys) {
+  std::vector<chain_operand> operands;
+  operands.reserve(ys.size() + 1);
+  operands.emplace_back(bitwise_and, x); // The operator is irrelevant here.
+  auto max_size = x.size();
+  for (auto& y : ys) {
+    operands.emplace_back(y.first, *y.second);
+    max_size = std::max(max_size, y.second->size());
+  }
+  // A min-heap over the positions where the current runs end. Exhausted
+  // operands behave like an infinite run of 0s.
+  using boundary = std::pair<size_type, size_t>;
+  std::priority_queue<
+    boundary, std::vector<boundary>, std::greater<boundary>
+  > boundaries;
+  auto load = [&](size_t i, size_type pos) {
+    auto& operand = operands[i];
+    operand.first = pos;
+    operand.last = operand.cursor.done()
+      ? std::numeric_limits<size_type>::max()
+      : pos + operand.cursor.words();
+    boundaries.emplace(operand.last, i);
+  };
+  for (auto i = 0u; i < operands.size(); ++i)
+    load(i, 0);
+  // Evaluate all full words segment by segment. Within a segment, we carry
+  // the intermediate result either as a clean word or as a pointer to a
+  // sequence of dirty words. The latter points into the first operand that
+  // made the result dirty as long as possible and only moves into the local
+  // buffer when we must modify it.
+  ewah_bitmap result;
+  std::vector<block_type> buffer;
+  auto words = max_size / word_type::width;
+  auto pos = size_type{0};
+  while (pos < words) {
+    auto next = std::min(boundaries.top().first, words);
+    auto n = next - pos;
+    if (buffer.size() < n)
+      buffer.resize(n);
+    auto own = [&](block_type const* xs) {
+      if (xs != buffer.data())
+        std::copy(xs, xs + n, buffer.begin());
+      return buffer.data();
+    };
+    auto& front = operands.front();
+    auto clean = front.clean();
+    auto fill = front.fill();
+    auto acc = clean ? nullptr : front.dirty(pos);
+    for (auto i = 1u; i < operands.size(); ++i) {
+      auto& operand = operands[i];
+      auto op = operand.op;
+      if (clean && operand.clean()) {
+        fill = apply(op, fill, operand.fill());
+      } else if (clean) {
+        auto xs = operand.dirty(pos);
+        auto none = apply(op, fill, word_type::none);
+        auto all = apply(op, fill, word_type::all);
+        if (none == all) {
+          fill = none; // The dirty words don't matter, e.g., 0 AND x.
+        } else if (none == word_type::none && all == word_type::all) {
+          acc = xs; // The result equals the dirty words, e.g., 1 AND x.
+          clean = false;
+        } else {
+          for (auto j = 0u; j < n; ++j)
+            buffer[j] = apply(op, fill, xs[j]);
+          acc = buffer.data();
+          clean = false;
+        }
+      } else if (operand.clean()) {
+        auto y = operand.fill();
+        auto none = apply(op, word_type::none, y);
+        auto all = apply(op, word_type::all, y);
+        if (none == all) {
+          fill = none; // The result becomes clean, e.g., x AND 0.
+          clean = true;
+        } else if (none != word_type::none || all != word_type::all) {
+          auto xs = own(acc);
+          for (auto j = 0u; j < n; ++j)
+            xs[j] = apply(op, xs[j], y);
+          acc = xs;
+        }
+      } else {
+        kernel(op)(buffer.data(), acc, operand.dirty(pos), n);
+        acc = buffer.data();
+      }
+    }
+    if (clean)
+      result.append_bits(fill != 0, n * word_type::width);
+    else
+      for (auto j = 0u; j < n; ++j)
+        result.append_block(acc[j]);
+    pos = next;
+    while (boundaries.top().first == pos) {
+      auto i = boundaries.top().second;
+      boundaries.pop();
+      operands[i].cursor.advance(operands[i].cursor.words());
+      load(i, pos);
+    }
+  }
+  // Evaluate the trailing partial word, if any. Since the unused bits in the
+  // last block of an EWAH bitmap are always 0, we can do so without masking.
+  auto partial = max_size % word_type::width;
+  if (partial > 0) {
+    auto block = operands.front().get(pos);
+    for (auto i = 1u; i < operands.size(); ++i)
+      block = apply(operands[i].op, block, operands[i].get(pos));
+    result.append_block(block, partial);
+  }
+  return result;
+}
+
+template <bool Bit>
+ewah_bitmap::size_type rank(ewah_bitmap const& bm, ewah_bitmap::size_type i) {
+  VAST_ASSERT(i < bm.size());
+  auto n = i + 1;
+  auto result = size_type{0};
+  word_cursor cursor{bm};
+  while (n > 0) {
+    auto words = cursor.words();
+    if (cursor.clean()) {
+      auto bits = std::min(words * word_type::width, n);
+      if (cursor.fill() != 0)
+        result += bits;
+      n -= bits;
+      cursor.advance(words);
+    } else if (n >= word_type::width) {
+      auto full = std::min(words, n / word_type::width);
+      result += detail::popcount_blocks(cursor.dirty(), full);
+      n -= full * word_type::width;
+      cursor.advance(full);
+    } else {
+      result += word_type::popcount(cursor.get() & word_type::lsb_fill(n));
+      n = 0;
+    }
+  }
+  return Bit ? result : i + 1 - result;
+}
+
+template ewah_bitmap::size_type
+rank<true>(ewah_bitmap const& bm, ewah_bitmap::size_type i);
+
+template ewah_bitmap::size_type
+rank<false>(ewah_bitmap const& bm, ewah_bitmap::size_type i);
+
+
+template <bool Bit>
+ewah_bitmap::size_type select(ewah_bitmap const& bm,
+                              ewah_bitmap::size_type i) {
+  return ewah_skip_index{bm}.select<Bit>(i);
+}
+
+template ewah_bitmap::size_type
+select<true>(ewah_bitmap const& bm, ewah_bitmap::size_type i);
+
+template ewah_bitmap::size_type
+select<false>(ewah_bitmap const& bm, ewah_bitmap::size_type i);
+
+// -- skip index --------------------------------------------------------------
+
+ewah_skip_index::ewah_skip_index(ewah_bitmap const& bm, size_type interval)
+  : bm_{&bm},
+    interval_{interval},
+    samples_{{0, 0, 0, 0}},
+    frontier_{samples_.front()} {
+  VAST_ASSERT(interval > 0);
+}
+
+template <class Predicate>
+void ewah_skip_index::extend(Predicate pred) const {
+  if (pred(frontier_))
+    return;
+  word_cursor cursor{*bm_, frontier_.origin, frontier_.offset};
+  auto pos = frontier_.word;
+  auto ones = frontier_.rank;
+  while (!cursor.done() && !pred(frontier_)) {
+    // Dirty runs may not extend beyond the next sample position, which
+    // bounds the number of words a query has to scan.
+    auto next = samples_.back().word + interval_;
+    auto n = cursor.words();
+    if (cursor.clean()) {
+      if (cursor.fill() != 0)
+        ones += n * word_type::width;
+    } else {
+      n = std::min(n, std::max(next, pos + 1) - pos);
+      ones += detail::popcount_blocks(cursor.dirty(), n);
+    }
+    pos += n;
+    cursor.advance(n);
+    frontier_ = {cursor.origin(), cursor.offset(), pos, ones};
+    if (pos >= next)
+      samples_.push_back(frontier_);
+  }
+}
+
+template <bool Bit>
+ewah_skip_index::size_type ewah_skip_index::count(sample const& x) const {
+  if (Bit)
+    return x.rank;
+  auto bits = std::min(x.word * word_type::width, bm_->size());
+  return bits - x.rank;
+}
+
+template <bool Bit>
+ewah_skip_index::size_type ewah_skip_index::rank(size_type i) const {
+  VAST_ASSERT(i < bm_->size());
+  auto w = i / word_type::width;
+  extend([=](auto& frontier) { return frontier.word > w; });
+  auto pred = [](auto word, auto& x) { return word < x.word; };
+  auto s = std::upper_bound(samples_.begin(), samples_.end(), w, pred);
+  VAST_ASSERT(s != samples_.begin());
+  --s;
+  word_cursor cursor{*bm_, s->origin, s->offset};
+  auto pos = s->word;
+  auto result = s->rank;
+  while (true) {
+    VAST_ASSERT(!cursor.done());
+    auto n = cursor.words();
+    if (pos + n <= w) {
+      if (!cursor.clean())
+        result += detail::popcount_blocks(cursor.dirty(), n);
+      else if (cursor.fill() != 0)
+        result += n * word_type::width;
+      pos += n;
+      cursor.advance(n);
+      continue;
+    }
+    auto k = w - pos;
+    auto bits = i % word_type::width + 1;
+    if (!cursor.clean()) {
+      auto xs = cursor.dirty();
+      result += detail::popcount_blocks(xs, k);
+      result += word_type::popcount(xs[k] & word_type::lsb_fill(bits));
+    } else if (cursor.fill() != 0) {
+      result += k * word_type::width + bits;
+    }
+    break;
+  }
+  return Bit ? result : i + 1 - result;
+}
+
+template <bool Bit>
+ewah_skip_index::size_type ewah_skip_index::rank() const {
+  extend([](auto&) { return false; });
+  return count<Bit>(frontier_);
+}
+
+template <bool Bit>
+ewah_skip_index::size_type ewah_skip_index::select(size_type i) const {
+  VAST_ASSERT(i > 0);
+  if (i == word_type::npos) {
+    auto n = rank<Bit>();
+    return n == 0 ? word_type::npos : select<Bit>(n);
+  }
+  extend([&](auto& frontier) { return count<Bit>(frontier) >= i; });
+  if (count<Bit>(frontier_) < i)
+    return word_type::npos;
+  auto pred = [&](auto n, auto& x) { return n <= count<Bit>(x); };
+  auto s = std::upper_bound(samples_.begin(), samples_.end(), i, pred);
+  VAST_ASSERT(s != samples_.begin());
+  --s;
+  word_cursor cursor{*bm_, s->origin, s->offset};
+  auto pos = s->word;
+  auto n = count<Bit>(*s);
+  while (!cursor.done()) {
+    if (cursor.clean()) {
+      auto words = cursor.words();
+      if ((cursor.fill() != 0) == Bit) {
+        auto bits = words * word_type::width;
+        if (n + bits >= i)
+          return pos * word_type::width + (i - n) - 1;
+        n += bits;
+      }
+      pos += words;
+      cursor.advance(words);
+    } else {
+      auto x = cursor.get();
+      auto valid = std::min(word_type::width,
+                            bm_->size() - pos * word_type::width);
+      auto ones = word_type::popcount(x);
+      auto k = Bit ? ones : valid - ones;
+      if (n + k >= i)
+        return pos * word_type::width + vast::select<Bit>(x, i - n);
+      n += k;
+      ++pos;
+      cursor.advance(1);
+    }
+  }
+  return word_type::npos;
+}
+
+ewah_skip_index::size_type ewah_skip_index::find_next(size_type i) const {
+  if (i == word_type::npos)
+    return select<1>(1);
+  if (i + 1 >= bm_->size())
+    return word_type::npos;
+  return select<1>(rank<1>(i) + 1);
+}
+
+template ewah_skip_index::size_type
+ewah_skip_index::rank<true>(size_type i) const;
+
+template ewah_skip_index::size_type
+ewah_skip_index::rank<false>(size_type i) const;
+
+template ewah_skip_index::size_type ewah_skip_index::rank<true>() const;
+
+template ewah_skip_index::size_type ewah_skip_index::rank<false>() const;
+
+template ewah_skip_index::size_type
+ewah_skip_index::select<true>(size_type i) const;
+
+template ewah_skip_index::size_type
+ewah_skip_index::select<false>(size_type i) const;
+
 } // namespace vast
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+#include <caf/streambuf.hpp>
+
+#include "vast/error.hpp"
+#include "vast/format/binary.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/detail/byte_swap.hpp"
+
+namespace vast {
+namespace format {
+namespace binary {
+
+writer::writer(std::unique_ptr<std::ostream> out, size_t frame_size)
+  : out_{std::move(out)},
+    frame_size_{frame_size} {
+  VAST_ASSERT(out_);
+  VAST_ASSERT(frame_size_ > 0);
+  VAST_ASSERT(frame_size_ < max_frame_size);
+  // A frame typically overshoots the threshold by a fraction of an event.
+  buffer_.reserve(header_size + frame_size_ + (frame_size_ >> 4));
+}
+
+writer::~writer() {
+  if (out_)
+    emit();
+}
+
+expected<void> writer::write(event const& e) {
+  // Leave room for the header, which we fill in when emitting the frame.
+  if (buffer_.empty())
+    buffer_.resize(header_size);
+  caf::vectorbuf buf{buffer_};
+  caf::stream_serializer<caf::vectorbuf&> sink{buf};
+  auto t = types_.find(e.type());
+  if (t == types_.end()) {
+    auto type_id = static_cast<uint32_t>(types_.size());
+    types_.emplace(e.type(), type_id);
+    sink << type_id << e.type();
+  } else {
+    sink << t->second;
+  }
+  sink << e.id() << e.timestamp() << e.data();
+  ++events_;
+  if (buffer_.size() - header_size >= frame_size_)
+    return emit();
+  return {};
+}
+
+expected<void> writer::flush() {
+  auto r = emit();
+  if (!r)
+    return r;
+  out_->flush();
+  if (!*out_)
+    return make_error(ec::format_error, "failed to flush");
+  return {};
+}
+
+const char* writer::name() const {
+  return "binary-writer";
+}
+
+expected<void> writer::emit() {
+  if (events_ == 0)
+    return {};
+  auto put = [&](size_t offset, auto x) {
+    x = detail::to_network_order(x);
+    std::memcpy(buffer_.data() + offset, &x, sizeof(x));
+  };
+  put(0, magic);
+  put(4, events_);
+  put(8, static_cast<uint64_t>(buffer_.size() - header_size));
+  out_->write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+  events_ = 0;
+  if (!*out_)
+    return make_error(ec::format_error, "failed to write frame");
+  return {};
+}
+
+reader::reader(std::unique_ptr<std::istream> in) : in_{std::move(in)} {
+  VAST_ASSERT(in_);
+}
+
+expected<event> reader::read() {
+  while (next_ == events_.size()) {
+    auto r = next_frame();
+    if (!r)
+      return r.error();
+  }
+  return std::move(events_[next_++]);
+}
+
+expected<void> reader::read(std::vector<event>& xs, size_t max) {
+  for (size_t produced = 0; produced < max; ) {
+    if (next_ == events_.size()) {
+      // Hand out what we have instead of waiting for the next frame.
+      if (produced > 0 && in_->rdbuf()->in_avail() == 0)
+        break;
+      auto r = next_frame();
+      if (!r)
+        return r;
+    }
+    auto n = std::min(max - produced, events_.size() - next_);
+    auto first = events_.begin() + next_;
+    xs.insert(xs.end(), std::make_move_iterator(first),
+              std::make_move_iterator(first + n));
+    next_ += n;
+    produced += n;
+  }
+  return no_error;
+}
+
+expected<void> reader::schema(vast::schema const&) {
+  return make_error(ec::format_error, "binary streams carry their own types");
+}
+
+expected<vast::schema> reader::schema() const {
+  vast::schema sch;
+  for (auto& x : types_)
+    sch.add(x.second);
+  return sch;
+}
+
+const char* reader::name() const {
+  return "binary-reader";
+}
+
+expected<void> reader::next_frame() {
+  char header[header_size];
+  in_->read(header, header_size);
+  if (in_->gcount() == 0)
+    return make_error(ec::end_of_input, "input exhausted");
+  if (static_cast<size_t>(in_->gcount()) != header_size)
+    return make_error(ec::format_error, "truncated frame header");
+  auto get = [&](size_t offset, auto x) {
+    std::memcpy(&x, header + offset, sizeof(x));
+    return detail::to_host_order(x);
+  };
+  if (get(0, uint32_t{0}) != magic)
+    return make_error(ec::format_error, "invalid frame magic");
+  auto n = get(4, uint32_t{0});
+  auto size = get(8, uint64_t{0});
+  // Every event occupies at least one byte, which bounds the event count.
+  if (size > max_frame_size)
+    return make_error(ec::format_error, "frame size exceeds maximum:", size);
+  if (n > size)
+    return make_error(ec::format_error, "frame has more events than bytes");
+  buffer_.resize(size);
+  in_->read(buffer_.data(), size);
+  if (static_cast<uint64_t>(in_->gcount()) != size)
+    return make_error(ec::format_error, "truncated frame");
+  events_.clear();
+  events_.reserve(n);
+  next_ = 0;
+  caf::charbuf buf{buffer_.data(), buffer_.size()};
+  caf::stream_deserializer<caf::charbuf&> source{buf};
+  try {
+    for (auto i = 0u; i < n; ++i) {
+      uint32_t type_id;
+      source >> type_id;
+      auto t = types_.find(type_id);
+      if (t == types_.end()) {
+        type new_type;
+        source >> new_type;
+        t = types_.emplace(type_id, std::move(new_type)).first;
+      }
+      event_id id;
+      timestamp ts;
+      data d;
+      source >> id >> ts >> d;
+      event e{{std::move(d), t->second}};
+      e.id(id);
+      e.timestamp(ts);
+      events_.push_back(std::move(e));
+    }
+  } catch (std::runtime_error const& e) {
+    return make_error(ec::format_error, e.what());
+  }
+  return {};
+}
+
+} // namespace binary
+} // namespace format
+} // namespace vast
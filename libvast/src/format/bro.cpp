@@ -1,12 +1,18 @@
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <future>
 #include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <thread>
 
 #include "vast/concept/printable/numeric.hpp"
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/data.hpp"
 #include "vast/concept/printable/vast/type.hpp"
 #include "vast/detail/assert.hpp"
-#include "vast/detail/fdoutbuf.hpp"
+#include "vast/detail/fdostream.hpp"
 #include "vast/detail/string.hpp"
 #include "vast/error.hpp"
 #include "vast/event.hpp"
@@ -20,6 +26,23 @@ namespace format {
 namespace bro {
 namespace {
 
+// Creates the nested record layout of *r* with all fields unset.
+vector make_skeleton(record_type const& r) {
+  vector xs(r.fields.size());
+  for (auto i = 0u; i < r.fields.size(); ++i)
+    if (auto nested = get_if<record_type>(r.fields[i].type))
+      xs[i] = make_skeleton(*nested);
+  return xs;
+}
+
+// Accesses the field at offset *o* in a record created by make_skeleton.
+data& field_at(vector& xs, offset const& o) {
+  auto x = &xs[o[0]];
+  for (auto i = 1u; i < o.size(); ++i)
+    x = &get<vector>(*x)[o[i]];
+  return *x;
+}
+
 // Creates a VAST type from an ASCII Bro type in a log header.
 expected<type> parse_type(std::string const& bro_type) {
   type t;
@@ -143,32 +166,36 @@ void stream_header(type const& t, std::ostream& out) {
   out << '\n';
 }
 
+// Renders data in Bro's log format. We append to a string, which the writer
+// hands to the output stream in large chunks.
 struct streamer {
-  streamer(std::ostream& out) : out_{out} {
+  streamer(std::string& out) : out_{out} {
   }
 
   template <class T>
   void operator()(T const&, none) const {
-    out_ << unset_field;
+    out_ += unset_field;
   }
 
   template <class T, class U>
   auto operator()(T const&, U const& x) const
   -> std::enable_if_t<!std::is_same<U, none>::value> {
-    out_ << to_string(x);
+    out_ += to_string(x);
   }
 
   void operator()(integer_type const&, integer i) const {
-    out_ << i;
+    auto out = std::back_inserter(out_);
+    integral_printer<integer>{}.print(out, i);
   }
 
   void operator()(count_type const&, count c) const {
-    out_ << c;
+    auto out = std::back_inserter(out_);
+    integral_printer<count>{}.print(out, c);
   }
 
   void operator()(real_type const&, real r) const {
     auto p = real_printer<real, 6>{};
-    auto out = std::ostreambuf_iterator<char>(out_);
+    auto out = std::back_inserter(out_);
     p.print(out, r);
   }
 
@@ -176,7 +203,7 @@ struct streamer {
     double d;
     convert(ts.time_since_epoch(), d);
     auto p = real_printer<real, 6>{};
-    auto out = std::ostreambuf_iterator<char>(out_);
+    auto out = std::back_inserter(out_);
     p.print(out, d);
   }
 
@@ -184,23 +211,24 @@ struct streamer {
     double d;
     convert(span, d);
     auto p = real_printer<real, 6>{};
-    auto out = std::ostreambuf_iterator<char>(out_);
+    auto out = std::back_inserter(out_);
     p.print(out, d);
   }
 
   void operator()(string_type const&, std::string const& str) const {
-    auto out = std::ostreambuf_iterator<char>{out_};
+    auto out = std::back_inserter(out_);
     auto f = str.begin();
     auto l = str.end();
     for ( ; f != l; ++f)
       if (!std::isprint(*f) || *f == separator || *f == set_separator)
         detail::hex_escaper(f, l, out);
       else
-        out_ << *f;
+        out_ += *f;
   }
 
   void operator()(port_type const&, port const& p) const {
-    out_ << p.number();
+    auto out = std::back_inserter(out_);
+    integral_printer<port::number_type>{}.print(out, p.number());
   }
 
   void operator()(record_type const& r, vector const& v) const {
@@ -208,7 +236,7 @@ struct streamer {
     VAST_ASSERT(r.fields.size() == v.size());
     visit(*this, r.fields[0].type, v[0]);
     for (auto i = 1u; i < v.size(); ++i) {
-      out_ << separator;
+      out_ += separator;
       visit(*this, r.fields[i].type, v[i]);
     }
   }
@@ -229,29 +257,73 @@ struct streamer {
   void stream(Container& c, type const& value_type, Sep const& sep) const {
     if (c.empty()) {
       // Cannot occur if we have a record
-      out_ << empty_field;
+      out_ += empty_field;
       return;
     }
     auto f = c.begin();
     auto l = c.end();
     visit(*this, value_type, *f);
     while (++f != l) {
-      out_ << sep;
+      out_ += sep;
       visit(*this, value_type, *f);
     }
   }
 
-  std::ostream& out_;
+  std::string& out_;
 };
 
+// The number of buffered bytes after which we write out a log.
+constexpr size_t buffer_size = 64 << 10;
+
 } // namespace <anonymous>
 
-reader::reader(std::unique_ptr<std::istream> input) : input_{std::move(input)} {
+reader::reader(std::unique_ptr<std::istream> input, size_t workers)
+  : input_{std::move(input)},
+    workers_{workers > 0 ? workers : std::thread::hardware_concurrency()} {
   VAST_ASSERT(input_);
-  lines_ = std::make_unique<detail::line_range>(*input_);
+  lines_ = std::make_unique<detail::chunked_line_range>(*input_);
+  if (workers_ == 0)
+    workers_ = 1;
 }
 
 expected<event> reader::read() {
+  if (current_ == buffer_.size()) {
+    buffer_.clear();
+    current_ = 0;
+    auto r = fill();
+    if (!r)
+      return r.error();
+    if (buffer_.empty())
+      return no_error;
+  }
+  return std::move(buffer_[current_++]);
+}
+
+expected<void> reader::read(std::vector<event>& xs, size_t max) {
+  for (size_t produced = 0; produced < max; ) {
+    if (current_ == buffer_.size()) {
+      // Hand out what we have instead of waiting for more input.
+      if (produced > 0 && !lines_->ready())
+        break;
+      buffer_.clear();
+      current_ = 0;
+      auto r = fill();
+      if (!r)
+        return r;
+      continue;
+    }
+    auto& x = buffer_[current_++];
+    if (x) {
+      xs.push_back(std::move(*x));
+      ++produced;
+    } else if (x.error()) {
+      VAST_WARNING(name(), "ignores bogus record:", x.error());
+    }
+  }
+  return no_error;
+}
+
+expected<void> reader::fill() {
   if (lines_->done())
     return make_error(ec::end_of_input, "input exhausted");
   if (is<none_type>(type_)) {
@@ -259,13 +331,19 @@ expected<event> reader::read() {
     if (!t)
       return t.error();
   }
-  // Check if we encountered a new log file.
-  lines_->next();
+  // The previous batch may have stopped at a header line without consuming it.
+  if (!pending_)
+    lines_->next();
+  pending_ = false;
   if (lines_->done())
     return make_error(ec::end_of_input, "input exhausted");
-  auto s = detail::split(lines_->get(), separator_);
-  if (s.size() > 0 && s[0].first != s[0].second && *s[0].first == '#') {
-    if (detail::starts_with(s[0].first, s[0].second, "#separator")) {
+  // Check if we encountered a new log file.
+  auto is_header = [](auto view) {
+    return view.first != view.second && *view.first == '#';
+  };
+  auto view = lines_->view();
+  if (is_header(view)) {
+    if (detail::starts_with(view.first, view.second, "#separator")) {
       VAST_DEBUG(name(), "restarts with new log");
       timestamp_field_ = -1;
       separator_.clear();
@@ -275,46 +353,119 @@ expected<event> reader::read() {
       lines_->next();
       if (lines_->done())
         return make_error(ec::end_of_input, "input exhausted");
-      s = detail::split(lines_->get(), separator_);
     } else {
       VAST_DEBUG(name(), "ignores comment at line",
                  lines_->line_number() << ':', lines_->get());
       return no_error;
     }
   }
-  if (s.size() != parsers_.size()) {
-    VAST_WARNING(name(), "ignores invalid record at line",
-                 lines_->line_number() << ':', "got", s.size(),
-                 "fields but need", parsers_.size());
-    return no_error;
+  // Gather all subsequent data lines that reside in the current chunk. Header
+  // lines change the parser state and terminate a batch.
+  batch_.clear();
+  batch_.push_back({lines_->view(), lines_->line_number()});
+  while (lines_->next_buffered()) {
+    if (is_header(lines_->view())) {
+      pending_ = true;
+      break;
+    }
+    batch_.push_back({lines_->view(), lines_->line_number()});
+  }
+  parse_batch();
+  return no_error;
+}
+
+void reader::parse_batch() {
+  // Spreading small batches over threads costs more than it saves.
+  static constexpr size_t min_lines_per_worker = 1024;
+  auto n = batch_.size();
+  auto workers = std::max(size_t{1},
+                          std::min(workers_, n / min_lines_per_worker));
+  std::vector<std::vector<expected<event>>> results(workers);
+  // Pairs of line number and field count of invalid records, which we report
+  // after joining the workers.
+  std::vector<std::vector<std::pair<size_t, size_t>>> invalid(workers);
+  auto work = [&](size_t i) {
+    std::vector<std::pair<iterator_type, iterator_type>> fields;
+    auto first = n * i / workers;
+    auto last = n * (i + 1) / workers;
+    results[i].reserve(last - first);
+    for (auto j = first; j < last; ++j) {
+      results[i].push_back(parse_line(batch_[j], fields));
+      if (!results[i].back() && !results[i].back().error())
+        invalid[i].emplace_back(batch_[j].number, fields.size());
+    }
+  };
+  std::vector<std::future<void>> futures;
+  for (auto i = 1u; i < workers; ++i)
+    futures.push_back(std::async(std::launch::async, work, i));
+  work(0);
+  for (auto& f : futures)
+    f.get();
+  for (auto& xs : invalid)
+    for (auto& x : xs)
+      VAST_WARNING(name(), "ignores invalid record at line", x.first << ':',
+                   "got", x.second, "fields but need", parsers_.size());
+  buffer_.reserve(n);
+  for (auto& xs : results)
+    std::move(xs.begin(), xs.end(), std::back_inserter(buffer_));
+}
+
+expected<event>
+reader::parse_line(line const& l,
+                   std::vector<std::pair<iterator_type, iterator_type>>& fields)
+const {
+  auto first = l.view.first;
+  auto last = l.view.second;
+  // Split the line into fields. Bro separates fields with a single tab, for
+  // which we can use the vectorized memchr.
+  fields.clear();
+  if (separator_.size() == 1) {
+    auto sep = separator_[0];
+    auto prev = first;
+    auto i = static_cast<iterator_type>(std::memchr(first, sep, last - first));
+    while (i != nullptr) {
+      fields.emplace_back(prev, i);
+      prev = i + 1;
+      i = static_cast<iterator_type>(std::memchr(prev, sep, last - prev));
+    }
+    if (prev != last)
+      fields.emplace_back(prev, last);
+  } else {
+    fields = detail::split(first, last, separator_);
   }
-  // Construct the record.
-  vector xs(s.size());
+  if (fields.size() != parsers_.size())
+    return no_error; // The caller reports invalid records.
+  // Parse the fields directly into their place in the nested record. This
+  // saves the allocations of a flat record and the subsequent unflattening.
+  auto xs = skeleton_;
   optional<timestamp> ts;
   auto is_unset = [&](auto i) {
     return std::equal(unset_field_.begin(), unset_field_.end(),
-                   s[i].first, s[i].second);
+                      fields[i].first, fields[i].second);
   };
   auto is_empty = [&](auto i) {
     return std::equal(empty_field_.begin(), empty_field_.end(),
-                      s[i].first, s[i].second);
+                      fields[i].first, fields[i].second);
   };
-  for (auto i = 0u; i < s.size(); ++i) {
+  for (auto i = 0u; i < fields.size(); ++i) {
     if (is_unset(i))
       continue;
-    if (is_empty(i))
-      xs[i] = construct(record_.fields[i].type);
-    else if (!parsers_[i](s[i].first, s[i].second, xs[i]))
-      return make_error(ec::parse_error,
-                        "field", i, "line", lines_->line_number(),
-                        std::string(s[i].first, s[i].second));
+    auto& x = field_at(xs, offsets_[i]);
+    if (is_empty(i)) {
+      x = construct(record_.fields[i].type);
+    } else if (verbatim_[i]) {
+      // Strings consume the entire field, so we can construct them in one go
+      // instead of growing them character by character.
+      x = bro_unescape(std::string(fields[i].first, fields[i].second));
+    } else if (!parsers_[i](fields[i].first, fields[i].second, x)) {
+      return make_error(ec::parse_error, "field", i, "line", l.number,
+                        std::string(fields[i].first, fields[i].second));
+    }
     if (i == static_cast<size_t>(timestamp_field_))
-      if (auto tp = get_if<timestamp>(xs[i]))
+      if (auto tp = get_if<timestamp>(x))
         ts = *tp;
   }
-  auto ys = unflatten(std::move(xs), type_);
-  VAST_ASSERT(ys);
-  event e{{std::move(*ys), type_}};
+  event e{{std::move(xs), type_}};
   e.timestamp(ts ? *ts : timestamp::clock::now());
   return e;
 }
@@ -448,74 +599,133 @@ expected<void> reader::parse_header() {
   }
   // Create Bro parsers.
   auto make_parser = [](auto const& type, auto const& set_sep) {
-    using iterator_type = std::string::const_iterator;
     return make_bro_parser<iterator_type>(type, set_sep);
   };
   parsers_.resize(record_.fields.size());
-  for (size_t i = 0; i < record_.fields.size(); i++)
-    parsers_[i] = make_parser(record_.fields[i].type, set_separator_);
+  verbatim_.resize(record_.fields.size());
+  for (size_t i = 0; i < record_.fields.size(); i++) {
+    auto& t = record_.fields[i].type;
+    parsers_[i] = make_parser(t, set_separator_);
+    verbatim_[i] = is<string_type>(t) || is<pattern_type>(t);
+  }
+  // Precompute the record layout that we parse into.
+  auto& r = get<record_type>(type_);
+  skeleton_ = make_skeleton(r);
+  offsets_.clear();
+  for (auto& f : record_type::each{r})
+    offsets_.push_back(f.offset);
+  VAST_ASSERT(offsets_.size() == record_.fields.size());
   return no_error;
 }
 
-writer::writer(path dir) {
+writer::writer(path dir, size_t workers)
+  : workers_{workers > 0 ? workers : std::thread::hardware_concurrency()} {
   if (dir != "-")
     dir_ = std::move(dir);
+  if (workers_ == 0)
+    workers_ = 1;
 }
 
 writer::~writer() {
   std::ostringstream ss;
   ss << "#close" << separator << time_factory{} << '\n';
   auto footer = ss.str();
-  for (auto& pair : streams_)
-    if (pair.second)
-      *pair.second << footer;
+  for (auto& pair : streams_) {
+    pair.second.buffer += footer;
+    emit(pair.second);
+  }
 }
 
 expected<void> writer::write(event const& e) {
   if (!is<record_type>(e.type()))
     return make_error(ec::format_error, "cannot process non-record events");
-  std::ostream* os = nullptr;
-  if (dir_.empty()) {
-    if (streams_.empty()) {
-      VAST_DEBUG(name(), "creates a new stream for STDOUT");
-      auto sb = std::make_unique<detail::fdoutbuf>(1);
-      auto out = std::make_unique<std::ostream>(sb.release());
-      auto i = streams_.emplace("", std::move(out));
-      stream_header(e.type(), *i.first->second);
+  auto l = stream(e.type());
+  if (!l)
+    return l.error();
+  auto& buf = (*l)->buffer;
+  visit(streamer{buf}, e.type(), e.data());
+  buf += '\n';
+  if (buf.size() >= buffer_size)
+    return emit(**l);
+  return no_error;
+}
+
+expected<void> writer::write(std::vector<event> const& xs) {
+  // Spreading small batches over threads costs more than it saves.
+  static constexpr size_t min_events_per_worker = 1024;
+  auto n = xs.size();
+  auto workers = std::max(size_t{1},
+                          std::min(workers_, n / min_events_per_worker));
+  if (workers == 1) {
+    for (auto& x : xs) {
+      auto r = write(x);
+      if (!r)
+        return r;
     }
-    os = streams_.begin()->second.get();
-  } else {
-    auto i = streams_.find(e.type().name());
-    if (i != streams_.end()) {
-      os = i->second.get();
-      VAST_ASSERT(os != nullptr);
-    } else {
-      VAST_DEBUG(name(), "creates new stream for event", e.type().name());
-      if (!exists(dir_)) {
-        auto d = mkdir(dir_);
-        if (!d)
-          return d.error();
-      } else if (!dir_.is_directory()) {
-        return make_error(ec::format_error, "got existing non-directory path",
-                          dir_);
+    return no_error;
+  }
+  // Each worker renders a contiguous slice of the batch into its own buffer
+  // and records where each line ends. Non-record events yield empty lines,
+  // which we reject when writing them out.
+  std::vector<std::string> buffers(workers);
+  std::vector<std::vector<size_t>> ends(workers);
+  auto work = [&](size_t i) {
+    auto first = n * i / workers;
+    auto last = n * (i + 1) / workers;
+    auto& buf = buffers[i];
+    ends[i].reserve(last - first);
+    for (auto j = first; j < last; ++j) {
+      if (is<record_type>(xs[j].type())) {
+        visit(streamer{buf}, xs[j].type(), xs[j].data());
+        buf += '\n';
+      }
+      ends[i].push_back(buf.size());
+    }
+  };
+  std::vector<std::future<void>> futures;
+  for (auto i = 1u; i < workers; ++i)
+    futures.push_back(std::async(std::launch::async, work, i));
+  work(0);
+  for (auto& f : futures)
+    f.get();
+  // Hand the lines to the buffers of their logs in order, with one append
+  // per run of events of the same type.
+  for (auto i = 0u; i < workers; ++i) {
+    auto first = n * i / workers;
+    auto& buf = buffers[i];
+    size_t begin = 0;
+    for (auto j = 0u; j < ends[i].size(); ) {
+      auto& t = xs[first + j].type();
+      if (!is<record_type>(t))
+        return make_error(ec::format_error,
+                          "cannot process non-record events");
+      auto k = j + 1;
+      while (k < ends[i].size() && xs[first + k].type() == t)
+        ++k;
+      auto l = stream(t);
+      if (!l)
+        return l.error();
+      auto end = ends[i][k - 1];
+      (*l)->buffer.append(buf.data() + begin, end - begin);
+      if ((*l)->buffer.size() >= buffer_size) {
+        auto r = emit(**l);
+        if (!r)
+          return r;
       }
-      auto filename = dir_ / (e.type().name() + ".log");
-      auto fos = std::make_unique<std::ofstream>(filename.str());
-      stream_header(e.type(), *fos);
-      auto i = streams_.emplace(e.type().name(), std::move(fos));
-      os = i.first->second.get();
+      begin = end;
+      j = k;
     }
   }
-  VAST_ASSERT(os != nullptr);
-  visit(streamer{*os}, e.type(), e.data());
-  *os << '\n';
   return no_error;
 }
 
 expected<void> writer::flush() {
-  for (auto& pair : streams_)
-    if (pair.second)
-      pair.second->flush();
+  for (auto& pair : streams_) {
+    auto r = emit(pair.second);
+    if (!r)
+      return r;
+    pair.second.out->flush();
+  }
   return no_error;
 }
 
@@ -523,6 +733,49 @@ const char* writer::name() const {
   return "bro-writer";
 }
 
+expected<writer::log*> writer::stream(type const& t) {
+  if (dir_.empty()) {
+    if (streams_.empty()) {
+      VAST_DEBUG(name(), "creates a new stream for STDOUT");
+      auto i = streams_.emplace("", log{});
+      auto& l = i.first->second;
+      l.out = std::make_unique<detail::fdostream>(1);
+      stream_header(t, *l.out);
+    }
+    return &streams_.begin()->second;
+  }
+  auto i = streams_.find(t.name());
+  if (i != streams_.end()) {
+    VAST_ASSERT(i->second.out != nullptr);
+    return &i->second;
+  }
+  VAST_DEBUG(name(), "creates new stream for event", t.name());
+  if (!exists(dir_)) {
+    auto d = mkdir(dir_);
+    if (!d)
+      return d.error();
+  } else if (!dir_.is_directory()) {
+    return make_error(ec::format_error, "got existing non-directory path",
+                      dir_);
+  }
+  auto filename = dir_ / (t.name() + ".log");
+  auto j = streams_.emplace(t.name(), log{});
+  auto& l = j.first->second;
+  l.out = std::make_unique<std::ofstream>(filename.str());
+  stream_header(t, *l.out);
+  return &l;
+}
+
+expected<void> writer::emit(log& l) {
+  if (l.buffer.empty())
+    return no_error;
+  l.out->write(l.buffer.data(), l.buffer.size());
+  l.buffer.clear();
+  if (!*l.out)
+    return make_error(ec::format_error, "failed to write log");
+  return no_error;
+}
+
 } // namespace bro
 } // namespace format
 } // namespace vast
@@ -1,16 +1,22 @@
 #include <netinet/in.h>
 
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <iterator>
 #include <thread>
 
 #include "vast/error.hpp"
 #include "vast/event.hpp"
 #include "vast/filesystem.hpp"
 #include "vast/logger.hpp"
+#include "vast/optional.hpp"
 
 #include "vast/format/pcap.hpp"
 
 #include "vast/detail/assert.hpp"
 #include "vast/detail/byte_swap.hpp"
+#include "vast/detail/mmapbuf.hpp"
 
 namespace vast {
 namespace format {
@@ -32,12 +38,140 @@ inline type make_packet_type() {
 
 static auto const pcap_packet_type = make_packet_type();
 
+// Reads an unsigned integer from a possibly unaligned location.
+template <class T>
+T load(uint8_t const* ptr, bool swapped) {
+  T x;
+  std::memcpy(&x, ptr, sizeof(T));
+  return swapped ? detail::byte_swap(x) : x;
+}
+
+// The magic numbers in the global header of a trace file.
+constexpr uint32_t pcap_magic_usec = 0xa1b2c3d4;
+constexpr uint32_t pcap_magic_nsec = 0xa1b23c4d;
+
+constexpr size_t pcap_file_header_size = 24;
+constexpr size_t pcap_record_header_size = 16;
+
+// The link type for Ethernet, which is the only one we can parse.
+constexpr uint32_t linktype_ethernet = 1;
+
+size_t next_power_of_two(size_t x) {
+  size_t result = 1;
+  while (result < x)
+    result <<= 1;
+  return result;
+}
+
 } // namespace <anonymous>
 
+flow_table::flow_table(size_t max_flows, uint64_t max_age)
+  : max_flows_{std::max(max_flows, size_t{1})},
+    max_age_{max_age} {
+  // Keeping the load factor at most 1/2 keeps probe sequences short.
+  slots_.resize(next_power_of_two(std::max(max_flows_ * 2, size_t{16})));
+  mask_ = slots_.size() - 1;
+  wheel_.resize(max_age_ + 2);
+}
+
+flow_table::flow& flow_table::lookup(connection const& conn, uint64_t now) {
+  if (wheel_time_ == 0)
+    wheel_time_ = now;
+  auto h = std::hash<connection>{}(conn);
+  auto i = find(conn, h);
+  if (slots_[i].occupied) {
+    slots_[i].state.last = now;
+    return slots_[i].state;
+  }
+  if (size_ == max_flows_) {
+    // Evict the first flow at or after a random position. Erasing shifts
+    // subsequent slots, so we need to probe again afterwards.
+    auto unif = std::uniform_int_distribution<size_t>{0, mask_};
+    auto j = unif(generator_);
+    while (!slots_[j].occupied)
+      j = (j + 1) & mask_;
+    erase(j);
+    i = find(conn, h);
+  }
+  auto& x = slots_[i];
+  x.conn = conn;
+  x.hash = h;
+  x.state = {0, now};
+  x.occupied = true;
+  ++size_;
+  schedule(x);
+  return x.state;
+}
+
+size_t flow_table::expire(uint64_t now) {
+  if (now <= wheel_time_)
+    return 0;
+  size_t result = 0;
+  // Process the buckets of all ticks since the last call, but each bucket at
+  // most once when time advanced by more than a full rotation.
+  auto ticks = std::min(now - wheel_time_,
+                        static_cast<uint64_t>(wheel_.size()));
+  for (auto t = now - ticks + 1; t <= now; ++t) {
+    due_.clear();
+    due_.swap(wheel_[t % wheel_.size()]);
+    for (auto& x : due_) {
+      auto i = find(x.conn, std::hash<connection>{}(x.conn));
+      // Skip timers of flows that have been evicted or rescheduled.
+      if (!slots_[i].occupied || slots_[i].deadline != x.deadline)
+        continue;
+      if (now - slots_[i].state.last > max_age_) {
+        erase(i);
+        ++result;
+      } else {
+        schedule(slots_[i]);
+      }
+    }
+  }
+  wheel_time_ = now;
+  return result;
+}
+
+size_t flow_table::size() const {
+  return size_;
+}
+
+size_t flow_table::find(connection const& conn, size_t hash) const {
+  auto i = hash & mask_;
+  while (slots_[i].occupied
+         && !(slots_[i].hash == hash && slots_[i].conn == conn))
+    i = (i + 1) & mask_;
+  return i;
+}
+
+void flow_table::erase(size_t i) {
+  VAST_ASSERT(slots_[i].occupied);
+  slots_[i].occupied = false;
+  --size_;
+  // Shift back subsequent entries of the probe sequence to close the gap,
+  // which avoids the need for tombstones.
+  auto j = i;
+  while (true) {
+    j = (j + 1) & mask_;
+    if (!slots_[j].occupied)
+      return;
+    auto home = slots_[j].hash & mask_;
+    if (((j - home) & mask_) >= ((j - i) & mask_)) {
+      slots_[i] = slots_[j];
+      slots_[j].occupied = false;
+      i = j;
+    }
+  }
+}
+
+void flow_table::schedule(slot& x) {
+  // A flow is due once it has been inactive for more than the maximum age.
+  x.deadline = x.state.last + max_age_ + 1;
+  wheel_[x.deadline % wheel_.size()].push_back({x.conn, x.deadline});
+}
 
 reader::reader(std::string input, uint64_t cutoff, size_t max_flows,
                size_t max_age, size_t expire_interval,
-               int64_t pseudo_realtime)
+               int64_t pseudo_realtime, size_t shards)
   : packet_type_{pcap_packet_type},
     cutoff_{cutoff},
     max_flows_{max_flows},
@@ -45,64 +179,160 @@ reader::reader(std::string input, uint64_t cutoff, size_t max_flows,
     expire_interval_{expire_interval},
     pseudo_realtime_{pseudo_realtime},
     input_{std::move(input)} {
+  if (shards == 0)
+    shards = 1;
+  // Each shard sees a disjoint subset of the flows, so they split the table
+  // capacity among each other.
+  auto flows_per_shard = (max_flows + shards - 1) / shards;
+  for (auto i = 0u; i < shards; ++i)
+    shards_.push_back({flow_table{flows_per_shard, max_age}, 0});
 }
 
+reader::reader(reader&&) = default;
+
+reader& reader::operator=(reader&&) = default;
+
 reader::~reader() {
   if (pcap_)
     ::pcap_close(pcap_);
 }
 
 expected<event> reader::read() {
-  char buf[PCAP_ERRBUF_SIZE]; // for errors.
-  if (!pcap_) {
-    // Determine interfaces.
-    pcap_if_t* iface;
-    if (::pcap_findalldevs(&iface, buf) == -1)
-      return make_error(ec::format_error,
-                        "failed to enumerate interfaces: ", buf);
-    for (auto i = iface; i != nullptr; i = i->next)
-      if (input_ == i->name) {
-        pcap_ = ::pcap_open_live(i->name, 65535, 1, 1000, buf);
-        if (!pcap_) {
-          ::pcap_freealldevs(iface);
-          return make_error(ec::format_error, "failed to open interface ",
-                            input_, ": ", buf);
-        }
-        if (pseudo_realtime_ > 0) {
-          pseudo_realtime_ = 0;
-          VAST_WARNING(name(), "ignores pseudo-realtime in live mode");
-        }
-        VAST_INFO(name(), "listens on interface " << i->name);
+  if (!pcap_ && !trace_) {
+    auto r = open();
+    if (!r)
+      return r.error();
+  }
+  auto p = next();
+  if (!p)
+    return p.error();
+  return make_event(*p);
+}
+
+expected<void> reader::read(std::vector<event>& xs, size_t max) {
+  if (shards_.size() > 1)
+    return read_sharded(xs, max);
+  if (!pcap_ && !trace_) {
+    auto r = open();
+    if (!r)
+      return r.error();
+  }
+  for (size_t produced = 0; produced < max; ) {
+    auto p = next();
+    if (!p) {
+      // In live mode, a timeout ends the batch so that we do not hold back
+      // the packets captured so far.
+      if (!p.error())
         break;
-      }
-    ::pcap_freealldevs(iface);
-    if (!pcap_) {
-      if (input_ != "-" && !exists(input_))
-        return make_error(ec::format_error, "no such file: ", input_);
-#ifdef PCAP_TSTAMP_PRECISION_NANO
-      pcap_ = ::pcap_open_offline_with_tstamp_precision(
-        input_.c_str(), PCAP_TSTAMP_PRECISION_NANO, buf);
-#else
-      pcap_ = ::pcap_open_offline(input_.c_str(), buf);
-#endif
-      if (!pcap_) {
-        flows_.clear();
-        return make_error(ec::format_error, "failed to open pcap file ",
-                          input_, ": ", std::string{buf});
-      }
-      VAST_INFO(name(), "reads trace from", input_);
-      if (pseudo_realtime_ > 0)
-        VAST_INFO(name(), "uses pseudo-realtime factor 1/" << pseudo_realtime_);
+      return p.error();
+    }
+    auto e = make_event(*p);
+    if (e) {
+      xs.push_back(std::move(*e));
+      ++produced;
+    } else if (e.error()) {
+      return e.error();
+    }
+  }
+  return no_error;
+}
+
+expected<void> reader::read_sharded(std::vector<event>& xs, size_t max) {
+  if (!pcap_ && !trace_) {
+    auto r = open();
+    if (!r)
+      return r.error();
+  }
+  struct job {
+    packet pkt;
+    dissection dis;
+    size_t offset;
+    size_t index;
+  };
+  // Capture packets on this thread and hand each one to the shard owning its
+  // flow. Packets from libpcap only live until the next capture, so we copy
+  // them into a buffer that lives for the duration of the batch.
+  std::vector<std::vector<job>> jobs(shards_.size());
+  std::vector<uint8_t> copies;
+  caf::error err;
+  size_t captured = 0;
+  for (; captured < max; ++captured) {
+    auto p = next();
+    if (!p) {
+      // In live mode, a timeout ends the batch so that we do not hold back
+      // the packets captured so far.
+      err = std::move(p.error());
+      break;
     }
-    VAST_INFO(name(), "cuts off flows after", cutoff_,
-                    "bytes in each direction");
-    VAST_INFO(name(), "keeps at most", max_flows_, "concurrent flows");
-    VAST_INFO(name(), "evicts flows after", max_age_ << "s of inactivity");
-    VAST_INFO(name(), "expires flow table every", expire_interval_ << "s");
+    auto d = dissect(*p);
+    if (!d) {
+      if (!d.error())
+        continue;
+      err = std::move(d.error());
+      break;
+    }
+    auto i = std::hash<connection>{}(d->conn) % shards_.size();
+    auto offset = copies.size();
+    if (!trace_)
+      copies.insert(copies.end(), p->data, p->data + p->caplen);
+    jobs[i].push_back({*p, std::move(*d), offset, captured});
+  }
+  if (!trace_)
+    for (auto& shard_jobs : jobs)
+      for (auto& j : shard_jobs)
+        j.pkt.data = copies.data() + j.offset;
+  // Process the shards in parallel. Each shard has exclusive access to its
+  // flow state, so the workers do not need to synchronize. Every worker puts
+  // its events into the slots of their packets, which restores the capture
+  // order. The importer assigns IDs in batch order, so IDs keep growing with
+  // time.
+  std::vector<optional<event>> results(captured);
+  auto work = [&](size_t i) {
+    for (auto& j : jobs[i]) {
+      auto e = process(shards_[i], j.pkt, j.dis);
+      if (e)
+        results[j.index] = std::move(*e);
+    }
+  };
+  std::vector<std::future<void>> futures;
+  for (auto i = 1u; i < shards_.size(); ++i)
+    if (!jobs[i].empty())
+      futures.push_back(std::async(std::launch::async, work, i));
+  work(0);
+  for (auto& f : futures)
+    f.get();
+  for (auto& x : results)
+    if (x)
+      xs.push_back(std::move(*x));
+  if (err)
+    return err;
+  return no_error;
+}
+
+expected<reader::packet> reader::next() {
+  packet result;
+  if (trace_) {
+    auto first = reinterpret_cast<uint8_t const*>(trace_->data());
+    auto remaining = trace_->size() - trace_offset_;
+    if (remaining == 0)
+      return make_error(ec::end_of_input, "reached end of trace");
+    if (remaining < pcap_record_header_size)
+      return make_error(ec::format_error, "truncated packet header");
+    auto hdr = first + trace_offset_;
+    result.secs = load<uint32_t>(hdr, trace_swapped_);
+    result.nsecs = load<uint32_t>(hdr + 4, trace_swapped_);
+    result.caplen = load<uint32_t>(hdr + 8, trace_swapped_);
+    result.len = load<uint32_t>(hdr + 12, trace_swapped_);
+    if (remaining - pcap_record_header_size < result.caplen)
+      return make_error(ec::format_error, "truncated packet");
+    result.data = hdr + pcap_record_header_size;
+    trace_offset_ += pcap_record_header_size + result.caplen;
+    if (!trace_nanoseconds_)
+      result.nsecs *= 1000;
+    return result;
   }
-  uint8_t const* data;
   pcap_pkthdr* header;
-  auto r = ::pcap_next_ex(pcap_, &header, &data);
+  auto r = ::pcap_next_ex(pcap_, &header, &result.data);
   if (r == 0)
     return no_error; // Attempt to fetch next packet timed out.
   if (r == -2) {
@@ -114,81 +344,113 @@ expected<event> reader::read() {
     pcap_ = nullptr;
     return make_error(ec::format_error, "failed to get next packet: ", err);
   }
-  // Parse packet.
-  connection conn;
-  auto packet_size = header->len - 14;
+  result.secs = header->ts.tv_sec;
+  result.nsecs = header->ts.tv_usec;
+#ifndef PCAP_TSTAMP_PRECISION_NANO
+  result.nsecs *= 1000;
+#endif
+  result.caplen = header->caplen;
+  result.len = header->len;
+  return result;
+}
+
+expected<event> reader::make_event(packet const& p) {
+  auto d = dissect(p);
+  if (!d)
+    return d.error();
+  auto& s = shards_.size() == 1
+    ? shards_[0]
+    : shards_[std::hash<connection>{}(d->conn) % shards_.size()];
+  auto e = process(s, p, *d);
+  if (e && pseudo_realtime_ > 0) {
+    auto ts = e->timestamp();
+    if (ts < last_timestamp_) {
+      VAST_WARNING(name(), "encountered non-monotonic packet timestamps:",
+                   ts.time_since_epoch().count(), '<',
+                   last_timestamp_.time_since_epoch().count());
+    }
+    if (last_timestamp_ != timestamp::min()) {
+      auto delta = ts - last_timestamp_;
+      std::this_thread::sleep_for(delta / pseudo_realtime_);
+    }
+    last_timestamp_ = ts;
+  }
+  return e;
+}
+
+expected<reader::dissection> reader::dissect(packet const& p) const {
+  auto data = p.data;
+  if (p.caplen < 14)
+    return no_error; // Skip packets without a complete link-layer header.
+  dissection result;
+  auto& conn = result.conn;
   auto layer3 = data + 14;
   uint8_t const* layer4 = nullptr;
   uint8_t layer4_proto = 0;
-  auto layer2_type = *reinterpret_cast<uint16_t const*>(data + 12);
-  uint64_t payload_size = packet_size;
+  auto layer2_type = load<uint16_t>(data + 12, false);
+  uint64_t payload_size = p.len - 14;
   switch (detail::to_host_order(layer2_type)) {
     default:
       return no_error; // Skip all non-IP packets.
     case 0x0800: {
-      if (header->len < 14 + 20)
+      if (p.caplen < 14 + 20)
         return make_error(ec::format_error, "IPv4 header too short");
       size_t header_size = (*layer3 & 0x0f) * 4;
       if (header_size < 20)
         return make_error(ec::format_error, "IPv4 header too short: ",
                           header_size, " bytes");
-      auto orig_h = reinterpret_cast<uint32_t const*>(layer3 + 12);
-      auto resp_h = reinterpret_cast<uint32_t const*>(layer3 + 16);
-      conn.src = {orig_h, address::ipv4, address::network};
-      conn.dst = {resp_h, address::ipv4, address::network};
+      conn.src = {layer3 + 12, address::ipv4, address::network};
+      conn.dst = {layer3 + 16, address::ipv4, address::network};
       layer4_proto = *(layer3 + 9);
       layer4 = layer3 + header_size;
       payload_size -= header_size;
     } break;
     case 0x86dd: {
-      if (header->len < 14 + 40)
+      if (p.caplen < 14 + 40)
         return make_error(ec::format_error, "IPv6 header too short");
-      auto orig_h = reinterpret_cast<uint32_t const*>(layer3 + 8);
-      auto resp_h = reinterpret_cast<uint32_t const*>(layer3 + 24);
-      conn.src = {orig_h, address::ipv4, address::network};
-      conn.dst = {resp_h, address::ipv4, address::network};
+      conn.src = {layer3 + 8, address::ipv6, address::network};
+      conn.dst = {layer3 + 24, address::ipv6, address::network};
       layer4_proto = *(layer3 + 6);
       layer4 = layer3 + 40;
       payload_size -= 40;
     } break;
   }
-  if (layer4_proto == IPPROTO_TCP) {
-    VAST_ASSERT(layer4);
-    auto orig_p = *reinterpret_cast<uint16_t const*>(layer4);
-    auto resp_p = *reinterpret_cast<uint16_t const*>(layer4 + 2);
-    orig_p = detail::to_host_order(orig_p);
-    resp_p = detail::to_host_order(resp_p);
+  // Do not look beyond the captured bytes.
+  auto end = data + p.caplen;
+  size_t layer4_size = layer4 < end ? end - layer4 : 0;
+  if (layer4_proto == IPPROTO_TCP && layer4_size >= 13) {
+    auto orig_p = detail::to_host_order(load<uint16_t>(layer4, false));
+    auto resp_p = detail::to_host_order(load<uint16_t>(layer4 + 2, false));
     conn.sport = {orig_p, port::tcp};
     conn.dport = {resp_p, port::tcp};
-    auto data_offset = *reinterpret_cast<uint8_t const*>(layer4 + 12) >> 4;
+    auto data_offset = *(layer4 + 12) >> 4;
     payload_size -= data_offset * 4;
-  } else if (layer4_proto == IPPROTO_UDP) {
-    VAST_ASSERT(layer4);
-    auto orig_p = *reinterpret_cast<uint16_t const*>(layer4);
-    auto resp_p = *reinterpret_cast<uint16_t const*>(layer4 + 2);
-    orig_p = detail::to_host_order(orig_p);
-    resp_p = detail::to_host_order(resp_p);
+  } else if (layer4_proto == IPPROTO_UDP && layer4_size >= 4) {
+    auto orig_p = detail::to_host_order(load<uint16_t>(layer4, false));
+    auto resp_p = detail::to_host_order(load<uint16_t>(layer4 + 2, false));
     conn.sport = {orig_p, port::udp};
     conn.dport = {resp_p, port::udp};
     payload_size -= 8;
-  } else if (layer4_proto == IPPROTO_ICMP) {
-    VAST_ASSERT(layer4);
-    auto message_type = *reinterpret_cast<uint8_t const*>(layer4);
-    auto message_code = *reinterpret_cast<uint8_t const*>(layer4 + 1);
+  } else if (layer4_proto == IPPROTO_ICMP && layer4_size >= 2) {
+    auto message_type = *layer4;
+    auto message_code = *(layer4 + 1);
     conn.sport = {message_type, port::icmp};
     conn.dport = {message_code, port::icmp};
     payload_size -= 8; // TODO: account for variable-size data.
   }
+  result.payload_size = payload_size;
+  return result;
+}
+
+expected<event> reader::process(shard& s, packet const& p,
+                                dissection const& d) const {
+  auto packet_size = p.len - 14;
+  auto payload_size = d.payload_size;
   // Parse packet timestamp
-  uint64_t packet_time = header->ts.tv_sec;
-  if (last_expire_ == 0)
-    last_expire_ = packet_time;
-  auto i = flows_.find(conn);
-  if (i == flows_.end())
-    i = flows_.emplace(conn, connection_state{0, packet_time}).first;
-  else
-    i->second.last = packet_time;
-  auto& flow_size = i->second.bytes;
+  uint64_t packet_time = p.secs;
+  if (s.last_expire == 0)
+    s.last_expire = packet_time;
+  auto& flow_size = s.flows.lookup(d.conn, packet_time).bytes;
   if (flow_size == cutoff_)
     return no_error; // Skip cut off packets.
   if (flow_size + payload_size <= cutoff_) {
@@ -199,67 +461,110 @@ expected<event> reader::read() {
     flow_size = cutoff_;
   }
   // Evict all elements that have been inactive for a while.
-  if (packet_time - last_expire_ > expire_interval_) {
-    last_expire_ = packet_time;
-    auto i = flows_.begin();
-    while (i != flows_.end())
-      if (packet_time - i->second.last > max_age_)
-        i = flows_.erase(i);
-      else
-        ++i;
-  }
-  // If the flow table gets too large, we evict a random element.
-  if (!flows_.empty() && flows_.size() % max_flows_ == 0) {
-    auto buckets = flows_.bucket_count();
-    auto unif1 = std::uniform_int_distribution<size_t>{0, buckets - 1};
-    auto bucket = unif1(generator_);
-    auto bucket_size = flows_.bucket_size(bucket);
-    while (bucket_size == 0) {
-      ++bucket;
-      bucket %= buckets;
-      bucket_size = flows_.bucket_size(bucket);
-    }
-    auto unif2 = std::uniform_int_distribution<size_t>{0, bucket_size - 1};
-    auto offset = unif2(generator_);
-    VAST_ASSERT(offset < bucket_size);
-    auto begin = flows_.begin(bucket);
-    std::advance(begin, offset);
-    flows_.erase(begin->first);
+  if (packet_time - s.last_expire > expire_interval_) {
+    s.last_expire = packet_time;
+    s.flows.expire(packet_time);
   }
   // Assemble packet.
   vector packet;
   vector meta;
-  meta.emplace_back(std::move(conn.src));
-  meta.emplace_back(std::move(conn.dst));
-  meta.emplace_back(std::move(conn.sport));
-  meta.emplace_back(std::move(conn.dport));
+  meta.reserve(4);
+  meta.emplace_back(d.conn.src);
+  meta.emplace_back(d.conn.dst);
+  meta.emplace_back(d.conn.sport);
+  meta.emplace_back(d.conn.dport);
+  packet.reserve(2);
   packet.emplace_back(std::move(meta));
-  // We start with the network layer and skip the link layer.
-  auto str = reinterpret_cast<char const*>(data + 14);
-  packet.emplace_back(std::string{str, packet_size});
+  // We start with the network layer and skip the link layer. Mapped traces
+  // let us copy the payload straight out of the file, and only once.
+  auto str = reinterpret_cast<char const*>(p.data + 14);
+  packet.emplace_back(std::string{str, std::min(packet_size, p.caplen - 14)});
   using namespace std::chrono;
-  auto secs = seconds(header->ts.tv_sec);
-  auto ts = timestamp{duration_cast<timespan>(secs)};
+  auto ts = timestamp{duration_cast<timespan>(seconds(p.secs))};
+  ts += nanoseconds(p.nsecs);
+  event e{{std::move(packet), packet_type_}};
+  e.timestamp(ts);
+  return e;
+}
+
+expected<void> reader::open() {
+  char buf[PCAP_ERRBUF_SIZE]; // for errors.
+  // Determine interfaces.
+  pcap_if_t* iface;
+  if (::pcap_findalldevs(&iface, buf) == -1)
+    return make_error(ec::format_error,
+                      "failed to enumerate interfaces: ", buf);
+  for (auto i = iface; i != nullptr; i = i->next)
+    if (input_ == i->name) {
+      pcap_ = ::pcap_open_live(i->name, 65535, 1, 1000, buf);
+      if (!pcap_) {
+        ::pcap_freealldevs(iface);
+        return make_error(ec::format_error, "failed to open interface ",
+                          input_, ": ", buf);
+      }
+      if (pseudo_realtime_ > 0) {
+        pseudo_realtime_ = 0;
+        VAST_WARNING(name(), "ignores pseudo-realtime in live mode");
+      }
+      VAST_INFO(name(), "listens on interface " << i->name);
+      break;
+    }
+  ::pcap_freealldevs(iface);
+  if (!pcap_) {
+    if (input_ != "-" && !exists(input_))
+      return make_error(ec::format_error, "no such file: ", input_);
+    if (input_ != "-" && map_trace()) {
+      VAST_INFO(name(), "maps trace", input_);
+    } else {
 #ifdef PCAP_TSTAMP_PRECISION_NANO
-  ts += nanoseconds(header->ts.tv_usec);
+      pcap_ = ::pcap_open_offline_with_tstamp_precision(
+        input_.c_str(), PCAP_TSTAMP_PRECISION_NANO, buf);
 #else
-  ts += microseconds(header->ts.tv_usec);
+      pcap_ = ::pcap_open_offline(input_.c_str(), buf);
 #endif
-  if (pseudo_realtime_ > 0) {
-    if (ts < last_timestamp_) {
-      VAST_WARNING(name(), "encountered non-monotonic packet timestamps:",
-                   ts.time_since_epoch().count(), '<',
-                   last_timestamp_.time_since_epoch().count());
+      if (!pcap_)
+        return make_error(ec::format_error, "failed to open pcap file ",
+                          input_, ": ", std::string{buf});
+      VAST_INFO(name(), "reads trace from", input_);
     }
-    if (last_timestamp_ != timestamp::min()) {
-      auto delta = ts - last_timestamp_;
-      std::this_thread::sleep_for(delta / pseudo_realtime_);
+    if (pseudo_realtime_ > 0 && shards_.size() > 1) {
+      pseudo_realtime_ = 0;
+      VAST_WARNING(name(), "ignores pseudo-realtime with multiple shards");
     }
-    last_timestamp_ = ts;
+    if (pseudo_realtime_ > 0)
+      VAST_INFO(name(), "uses pseudo-realtime factor 1/" << pseudo_realtime_);
   }
-  event e{{std::move(packet), packet_type_}};
-  e.timestamp(ts);
-  return e;
+  VAST_INFO(name(), "cuts off flows after", cutoff_,
+                  "bytes in each direction");
+  VAST_INFO(name(), "keeps at most", max_flows_, "concurrent flows");
+  VAST_INFO(name(), "evicts flows after", max_age_ << "s of inactivity");
+  VAST_INFO(name(), "expires flow table every", expire_interval_ << "s");
+  if (shards_.size() > 1)
+    VAST_INFO(name(), "distributes flows over", shards_.size(), "shards");
+  return no_error;
+}
+
+bool reader::map_trace() {
+  auto trace = std::make_unique<detail::mmapbuf>(input_);
+  if (!trace->data() || trace->size() < pcap_file_header_size)
+    return false;
+  auto hdr = reinterpret_cast<uint8_t const*>(trace->data());
+  auto magic = load<uint32_t>(hdr, false);
+  if (magic == pcap_magic_usec || magic == pcap_magic_nsec) {
+    trace_swapped_ = false;
+  } else if (detail::byte_swap(magic) == pcap_magic_usec
+             || detail::byte_swap(magic) == pcap_magic_nsec) {
+    trace_swapped_ = true;
+    magic = detail::byte_swap(magic);
+  } else {
+    return false; // Let libpcap deal with other formats, e.g., pcapng.
+  }
+  if (load<uint32_t>(hdr + 20, trace_swapped_) != linktype_ethernet)
+    return false;
+  trace_nanoseconds_ = magic == pcap_magic_nsec;
+  trace_offset_ = pcap_file_header_size;
+  trace_ = std::move(trace);
+  return true;
 }
 
 expected<void> reader::schema(vast::schema const& sch) {
@@ -241,6 +241,16 @@ expected<event> reader::read() {
   return e;
 }
 
+expected<void> reader::read(std::vector<event>& xs, size_t max) {
+  for (size_t i = 0; i < max; ++i) {
+    auto e = read();
+    if (!e)
+      return e.error();
+    xs.push_back(std::move(*e));
+  }
+  return no_error;
+}
+
 expected<void> reader::schema(vast::schema sch) {
   if (sch.empty())
     return make_error(ec::format_error, "empty schema");
@@ -1,6 +1,64 @@
+#include <algorithm>
+
 #include "vast/null_bitmap.hpp"
+#include "vast/detail/block_kernels.hpp"
 
 namespace vast {
+namespace {
+
+using bitvector_type = null_bitmap::bitvector_type;
+using size_type = null_bitmap::size_type;
+using word_type = null_bitmap::word_type;
+
+// Appends the bits in *[first,last)* of *src* to *dst*.
+void append_range(bitvector_type& dst, bitvector_type const& src,
+                  size_type first, size_type last) {
+  auto& blocks = src.blocks();
+  while (first < last) {
+    auto offset = first % word_type::width;
+    auto n = std::min(word_type::width - offset, last - first);
+    auto block = blocks[first / word_type::width] >> offset;
+    dst.append_block(block & word_type::lsb_fill(n), n);
+    first += n;
+  }
+}
+
+// Applies a block kernel over the common prefix of two bitvectors and then
+// extends the result according to the same fill semantics as binary_eval.
+template <class Kernel, class Operation>
+bitvector_type eval(bitvector_type const& lhs, bitvector_type const& rhs,
+                    Kernel kernel, Operation op, bool fill_lhs,
+                    bool fill_rhs) {
+  auto min_size = std::min(lhs.size(), rhs.size());
+  auto max_size = std::max(lhs.size(), rhs.size());
+  auto full = min_size / word_type::width;
+  std::vector<null_bitmap::block_type> blocks(full);
+  kernel(blocks.data(), lhs.blocks().data(), rhs.blocks().data(), full);
+  bitvector_type result;
+  result.reserve(max_size);
+  result.append_blocks(blocks.begin(), blocks.end());
+  // If the shorter bitvector ends within a block, we evaluate that block over
+  // the extent of the longer bitvector, treating missing bits as 0.
+  auto pos = result.size();
+  if (min_size % word_type::width > 0) {
+    auto valid = [&](auto& bv) {
+      auto n = std::min(word_type::width, bv.size() - pos);
+      return bv.blocks()[full] & word_type::lsb_fill(n);
+    };
+    auto n = std::min(word_type::width, max_size - pos);
+    result.append_block(op(valid(lhs), valid(rhs)) & word_type::lsb_fill(n), n);
+    pos += n;
+  }
+  if (!fill_lhs && !fill_rhs)
+    result.resize(max_size, false);
+  else if (fill_lhs && lhs.size() > pos)
+    append_range(result, lhs, pos, lhs.size());
+  else if (fill_rhs && rhs.size() > pos)
+    append_range(result, rhs, pos, rhs.size());
+  return result;
+}
+
+} // namespace <anonymous>
 
 null_bitmap::null_bitmap(size_type n, bool bit) {
   append_bits(bit, n);
@@ -34,6 +92,55 @@ bool operator==(null_bitmap const& x, null_bitmap const& y) {
   return x.bitvector_ == y.bitvector_;
 }
 
+null_bitmap binary_and(null_bitmap const& x, null_bitmap const& y) {
+  auto op = [](auto lhs, auto rhs) { return lhs & rhs; };
+  null_bitmap result;
+  result.bitvector_ = eval(x.bitvector_, y.bitvector_, detail::and_blocks, op,
+                           false, false);
+  return result;
+}
+
+null_bitmap binary_or(null_bitmap const& x, null_bitmap const& y) {
+  auto op = [](auto lhs, auto rhs) { return lhs | rhs; };
+  null_bitmap result;
+  result.bitvector_ = eval(x.bitvector_, y.bitvector_, detail::or_blocks, op,
+                           true, true);
+  return result;
+}
+
+null_bitmap binary_xor(null_bitmap const& x, null_bitmap const& y) {
+  auto op = [](auto lhs, auto rhs) { return lhs ^ rhs; };
+  null_bitmap result;
+  result.bitvector_ = eval(x.bitvector_, y.bitvector_, detail::xor_blocks, op,
+                           true, true);
+  return result;
+}
+
+null_bitmap binary_nand(null_bitmap const& x, null_bitmap const& y) {
+  auto op = [](auto lhs, auto rhs) { return lhs & ~rhs; };
+  null_bitmap result;
+  result.bitvector_ = eval(x.bitvector_, y.bitvector_, detail::and_not_blocks,
+                           op, true, false);
+  return result;
+}
+
+template <bool Bit>
+uint64_t rank(null_bitmap const& bm, uint64_t i) {
+  VAST_ASSERT(i < bm.size());
+  auto n = i + 1;
+  auto blocks = bm.bitvector_.blocks().data();
+  auto full = n / word_type::width;
+  auto partial = n % word_type::width;
+  auto result = detail::popcount_blocks(blocks, full);
+  if (partial > 0)
+    result += word_type::popcount(blocks[full] & word_type::lsb_fill(partial));
+  return Bit ? result : n - result;
+}
+
+template uint64_t rank<true>(null_bitmap const& bm, uint64_t i);
+
+template uint64_t rank<false>(null_bitmap const& bm, uint64_t i);
+
 
 null_bitmap_range::null_bitmap_range(null_bitmap const& bm)
   : bitvector_{&bm.bitvector_},
@@ -70,7 +177,7 @@ void null_bitmap_range::scan() {
     if (block_ == last) {
       auto partial = bitvector_->size() % word_type::width;
       if (partial > 0) {
-        auto mask = word_type::mask(partial);
+        auto mask = word_type::lsb_mask(partial);
         if ((*block_ & mask) == (data & mask)) {
           n += partial;
           ++block_;
@@ -0,0 +1,67 @@
+#include <algorithm>
+
+#include "vast/projection.hpp"
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/key.hpp"
+
+namespace vast {
+
+projection::projection(std::vector<key> keys) : keys_{std::move(keys)} {
+}
+
+optional<event> projection::operator()(event const& e) {
+  if (keys_.empty())
+    return e;
+  auto r = get_if<record_type>(e.type());
+  if (!r)
+    return e;
+  auto& l = make_layout(*r, e.type());
+  if (l.offsets.empty())
+    return {};
+  vector xs;
+  xs.reserve(l.offsets.size());
+  for (auto& o : l.offsets) {
+    auto x = get(e.data(), o);
+    xs.push_back(x ? *x : nil);
+  }
+  event result{value{std::move(xs), l.projected}};
+  result.id(e.id());
+  result.timestamp(e.timestamp());
+  return result;
+}
+
+std::vector<key> const& projection::keys() const {
+  return keys_;
+}
+
+bool projection::empty() const {
+  return keys_.empty();
+}
+
+projection::layout const& projection::make_layout(record_type const& r,
+                                                  type const& t) {
+  auto i = layouts_.find(t);
+  if (i != layouts_.end())
+    return i->second;
+  layout l;
+  std::vector<record_field> fields;
+  for (auto& k : keys_)
+    for (auto& x : r.find_suffix(k)) {
+      // Select every field only once, even if multiple keys match it.
+      auto& os = l.offsets;
+      if (std::find(os.begin(), os.end(), x.first) != os.end())
+        continue;
+      auto name = r.resolve(x.first);
+      auto field_type = r.at(x.first);
+      if (!name || !field_type)
+        continue;
+      os.push_back(x.first);
+      fields.emplace_back(to_string(*name), *field_type);
+    }
+  auto projected = record_type{std::move(fields)};
+  projected.name(t.name());
+  l.projected = std::move(projected);
+  return layouts_.emplace(t, std::move(l)).first->second;
+}
+
+} // namespace vast
@@ -0,0 +1,302 @@
+#include <algorithm>
+
+#include "vast/concept/hashable/uhash.hpp"
+#include "vast/concept/hashable/xxhash.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/event.hpp"
+#include "vast/expression_visitors.hpp"
+#include "vast/query_matcher.hpp"
+
+namespace vast {
+
+namespace {
+
+// Retrieves the value an extractor refers to, or nullptr if the event has no
+// such value.
+data const* extract(event const& e, predicate::operand const& x, data& tmp) {
+  if (auto de = get_if<data_extractor>(x)) {
+    if (de->offset.empty())
+      return &e.data();
+    if (auto r = get_if<vector>(e.data()))
+      return get(*r, de->offset);
+  } else if (auto ae = get_if<attribute_extractor>(x)) {
+    if (ae->attr == "type") {
+      tmp = e.type().name();
+      return &tmp;
+    }
+    if (ae->attr == "time") {
+      tmp = e.timestamp();
+      return &tmp;
+    }
+  }
+  return nullptr;
+}
+
+// Checks whether we can answer a predicate with a hash table lookup on the
+// value of its LHS.
+bool is_indexable(predicate const& p) {
+  if (!is<data_extractor>(p.lhs) && !is<attribute_extractor>(p.lhs))
+    return false;
+  auto rhs = get_if<data>(p.rhs);
+  if (!rhs)
+    return false;
+  if (p.op == equal)
+    return true;
+  return p.op == in && (is<set>(*rhs) || is<vector>(*rhs));
+}
+
+} // namespace <anonymous>
+
+// Translates a tailored expression into postfix code and assigns IDs to its
+// predicates, sharing them with all previously compiled queries.
+struct query_matcher::compiler {
+  void operator()(none) {
+    code.push_back({instruction::any, 0});
+  }
+
+  void operator()(conjunction const& c) {
+    for (auto& x : c)
+      visit(*this, x);
+    code.push_back({instruction::all, static_cast<uint32_t>(c.size())});
+  }
+
+  void operator()(disjunction const& d) {
+    for (auto& x : d)
+      visit(*this, x);
+    code.push_back({instruction::any, static_cast<uint32_t>(d.size())});
+  }
+
+  void operator()(negation const& n) {
+    visit(*this, n.expr());
+    code.push_back({instruction::negate, 0});
+  }
+
+  void operator()(predicate const& p) {
+    auto i = ids.find(p);
+    if (i == ids.end()) {
+      i = ids.emplace(p, static_cast<uint32_t>(predicates.size())).first;
+      predicates.push_back(p);
+    }
+    code.push_back({instruction::load, i->second});
+  }
+
+  std::vector<instruction> code;
+  std::unordered_map<predicate, uint32_t>& ids;
+  std::vector<predicate>& predicates;
+};
+
+size_t query_matcher::data_hash::operator()(data const& x) const {
+  return uhash<xxhash>{}(x);
+}
+
+bool query_matcher::add(query_id id, expression expr) {
+  auto i = queries_.emplace(id, std::move(expr));
+  if (!i.second)
+    return false;
+  for (auto& x : types_)
+    attach(x.second, x.first, id, i.first->second);
+  return true;
+}
+
+bool query_matcher::remove(query_id id) {
+  if (queries_.erase(id) == 0)
+    return false;
+  for (auto i = types_.begin(); i != types_.end(); )
+    if (detach(i->second, id))
+      ++i;
+    else
+      i = types_.erase(i);
+  return true;
+}
+
+void query_matcher::match(event const& e, std::vector<query_id>& result) {
+  if (queries_.empty())
+    return;
+  auto& ct = compile(e.type());
+  if (ct.programs.empty())
+    return;
+  auto hit = [&](uint32_t p) {
+    if (satisfied_[p])
+      return;
+    satisfied_[p] = true;
+    hits_.push_back(p);
+    for (auto q : ct.subscribers[p])
+      if (counts_[q]++ == 0)
+        touched_.push_back(q);
+  };
+  // Find all satisfied predicates.
+  data tmp;
+  for (auto& idx : ct.indexes)
+    if (auto x = extract(e, idx.extractor, tmp)) {
+      auto i = idx.values.find(*x);
+      if (i != idx.values.end())
+        for (auto p : i->second)
+          hit(p);
+    }
+  event_evaluator evaluator{e};
+  for (auto& x : ct.scanned)
+    if (evaluator(x.first))
+      hit(x.second);
+  // Only queries with at least one satisfied predicate can match, except for
+  // those that hold when no predicate does.
+  auto first = result.size();
+  for (auto q : touched_) {
+    auto& prog = ct.programs[q];
+    if (prog.conjunctive ? counts_[q] == prog.predicates : run(prog))
+      result.push_back(prog.id);
+  }
+  for (auto q : ct.always)
+    if (counts_[q] == 0)
+      result.push_back(ct.programs[q].id);
+  std::sort(result.begin() + first, result.end());
+  for (auto q : touched_)
+    counts_[q] = 0;
+  for (auto p : hits_)
+    satisfied_[p] = false;
+  touched_.clear();
+  hits_.clear();
+}
+
+size_t query_matcher::size() const {
+  return queries_.size();
+}
+
+bool query_matcher::empty() const {
+  return queries_.empty();
+}
+
+query_matcher::compiled_type& query_matcher::compile(type const& t) {
+  auto i = types_.find(t);
+  if (i != types_.end())
+    return i->second;
+  compiled_type result;
+  for (auto& q : queries_)
+    attach(result, t, q.first, q.second);
+  return types_.emplace(t, std::move(result)).first->second;
+}
+
+void query_matcher::attach(compiled_type& ct, type const& t, query_id id,
+                           expression const& expr) {
+  auto x = tailor(expr, t);
+  if (!x || !visit(matcher{t}, *x))
+    return;
+  auto first = static_cast<uint32_t>(ct.predicates.size());
+  compiler c{{}, ct.ids, ct.predicates};
+  visit(c, *x);
+  program prog;
+  prog.id = id;
+  prog.code = std::move(c.code);
+  auto is_load = [](auto& i) { return i.op == instruction::load; };
+  auto loads = std::count_if(prog.code.begin(), prog.code.end(), is_load);
+  auto n = prog.code.size();
+  auto ends_in_all = n > 0 && prog.code.back().op == instruction::all;
+  prog.conjunctive =
+    loads > 0 && (n == 1 || (n == size_t(loads) + 1 && ends_in_all));
+  for (auto& i : prog.code)
+    if (i.op == instruction::load)
+      prog.distinct.push_back(i.arg);
+  std::sort(prog.distinct.begin(), prog.distinct.end());
+  prog.distinct.erase(std::unique(prog.distinct.begin(), prog.distinct.end()),
+                      prog.distinct.end());
+  prog.predicates = static_cast<uint32_t>(prog.distinct.size());
+  ct.subscribers.resize(ct.predicates.size());
+  auto q = static_cast<uint32_t>(ct.programs.size());
+  for (auto p : prog.distinct) {
+    // A predicate of a removed query may come back to life.
+    if (p < first && ct.subscribers[p].empty())
+      --ct.unused;
+    ct.subscribers[p].push_back(q);
+  }
+  ct.programs.push_back(std::move(prog));
+  // Put new predicates into value indexes where possible and evaluate the
+  // remaining ones one by one.
+  for (auto k = first; k < ct.predicates.size(); ++k) {
+    auto& p = ct.predicates[k];
+    if (!is_indexable(p)) {
+      ct.scanned.emplace_back(p, k);
+      continue;
+    }
+    auto idx = std::find_if(ct.indexes.begin(), ct.indexes.end(),
+                            [&](auto& x) { return x.extractor == p.lhs; });
+    if (idx == ct.indexes.end()) {
+      ct.indexes.push_back({p.lhs, {}});
+      idx = ct.indexes.end() - 1;
+    }
+    auto& rhs = get<data>(p.rhs);
+    if (p.op == equal) {
+      idx->values[rhs].push_back(k);
+    } else if (auto xs = get_if<set>(rhs)) {
+      for (auto& x : *xs)
+        idx->values[x].push_back(k);
+    } else {
+      for (auto& x : get<vector>(rhs))
+        idx->values[x].push_back(k);
+    }
+  }
+  if (satisfied_.size() < ct.predicates.size())
+    satisfied_.resize(ct.predicates.size());
+  if (counts_.size() < ct.programs.size())
+    counts_.resize(ct.programs.size());
+  // Programs that hold without any satisfied predicate, e.g., negations, are
+  // candidates for every event.
+  if (run(ct.programs.back()))
+    ct.always.push_back(q);
+}
+
+bool query_matcher::detach(compiled_type& ct, query_id id) {
+  auto pred = [&](auto& x) { return x.id == id; };
+  auto i = std::find_if(ct.programs.begin(), ct.programs.end(), pred);
+  if (i == ct.programs.end())
+    return true;
+  auto q = static_cast<uint32_t>(i - ct.programs.begin());
+  auto last = static_cast<uint32_t>(ct.programs.size() - 1);
+  auto replace = [](std::vector<uint32_t>& xs, uint32_t x, uint32_t y) {
+    std::replace(xs.begin(), xs.end(), x, y);
+  };
+  for (auto p : i->distinct) {
+    auto& subs = ct.subscribers[p];
+    subs.erase(std::find(subs.begin(), subs.end(), q));
+    if (subs.empty())
+      ++ct.unused;
+  }
+  ct.always.erase(std::remove(ct.always.begin(), ct.always.end(), q),
+                  ct.always.end());
+  // Move the last program into the freed slot.
+  if (q != last) {
+    for (auto p : ct.programs[last].distinct)
+      replace(ct.subscribers[p], last, q);
+    replace(ct.always, last, q);
+    ct.programs[q] = std::move(ct.programs[last]);
+  }
+  ct.programs.pop_back();
+  // Unused predicates still cost a lookup or an evaluation per event.
+  return ct.unused * 2 <= ct.predicates.size();
+}
+
+bool query_matcher::run(program const& p) {
+  stack_.clear();
+  for (auto& i : p.code) {
+    switch (i.op) {
+      case instruction::load:
+        stack_.push_back(satisfied_[i.arg]);
+        break;
+      case instruction::all:
+      case instruction::any: {
+        auto first = stack_.end() - i.arg;
+        auto x = i.op == instruction::all
+          ? std::find(first, stack_.end(), false) == stack_.end()
+          : std::find(first, stack_.end(), true) != stack_.end();
+        stack_.erase(first, stack_.end());
+        stack_.push_back(x);
+        break;
+      }
+      case instruction::negate:
+        stack_.back() = !stack_.back();
+        break;
+    }
+  }
+  VAST_ASSERT(stack_.size() == 1);
+  return stack_.back();
+}
+
+} // namespace vast
@@ -34,14 +34,18 @@ void segment::add(batch&& b) {
   batches_.emplace(min, std::move(b));
 }
 
-// FIXME: this algorithm is not very efficient. It operates in O(MN) time where
-// M is the number of batches and N the size of the bitmap. Conceptually,
-// there's a straight-forward O(log M * N) or even O(N) algorithm by walking
-// through the query bitmap in lock-step with the batches.
 expected<std::vector<event>> segment::extract(bitmap const& bm) const {
+  return extract(bitmap_skip_index{bm});
+}
+
+// All batches share the skip index over the query bitmap. Instead of walking
+// the bitmap from the beginning, each batch reader jumps directly to the first
+// ID in its range.
+expected<std::vector<event>>
+segment::extract(bitmap_skip_index const& ids) const {
   std::vector<event> result;
-  auto min = select(bm, 1);
-  auto max = select(bm, -1);
+  auto min = ids.select(1);
+  auto max = ids.select(-1);
   // FIXME: what we really want here is detail::range_map, but it's currently
   // missing lower_bound()/upper_bound() functionality, so we emulate it here.
   auto begin = batches_.lower_bound(min);
@@ -51,7 +55,7 @@ expected<std::vector<event>> segment::extract(bitmap const& bm) const {
   auto end = batches_.upper_bound(max);
   for (; begin != end; ++begin) {
     batch::reader reader{begin->second};
-    auto xs = reader.read(bm);
+    auto xs = reader.read(ids);
     if (!xs)
       return xs;
     result.reserve(result.size() + xs->size());
@@ -145,7 +149,7 @@ archive(archive_type::stateful_pointer<archive_state> self,
     self->state.accountant = actor_cast<accountant_type>(acc);
   }
   return {
-    [=](std::vector<event> const& events) {
+    [=](event_slice const& events) -> result<ok_atom> {
       VAST_ASSERT(!events.empty());
       // Ensure that all events have strictly monotonic IDs
       auto non_monotonic = [](auto& x, auto& y) {
@@ -156,19 +160,20 @@ archive(archive_type::stateful_pointer<archive_state> self,
       if (!valid) {
         VAST_WARNING(self, "ignores", events.size(),
                      "events with non-monotonic IDs");
-        return;
+        return ok_atom::value;
       }
       // Construct a batch from the events.
-      auto first_id = events.front().id();
-      auto last_id  = events.back().id();
+      auto first_id = events.first_id();
+      auto last_id = events.last_id() - 1;
       VAST_DEBUG(self, "got", events.size(),
                  "events [" << first_id << ',' << (last_id + 1) << ')');
       auto start = steady_clock::now();
       batch::writer writer{compression::lz4};
       for (auto& e : events)
         if (!writer.write(e)) {
-          self->quit(make_error(ec::unspecified, "failed to create batch"));
-          return;
+          auto err = make_error(ec::unspecified, "failed to create batch");
+          self->quit(err);
+          return err;
         }
       auto b = writer.seal();
       b.ids(first_id, last_id + 1);
@@ -189,12 +194,13 @@ archive(archive_type::stateful_pointer<archive_state> self,
         auto result = flush_active_segment(self);
         if (!result) {
           self->quit(result.error());
-          return;
+          return result.error();
         }
       }
       auto active_id = self->state.active.id();
       self->state.segments.inject(first_id, last_id + 1, active_id);
       self->state.active.add(std::move(b));
+      return ok_atom::value;
     },
     [=](flush_atom) -> flush_promise {
       auto rp = self->make_response_promise<flush_promise>();
@@ -215,17 +221,18 @@ archive(archive_type::stateful_pointer<archive_state> self,
       // Collect candidate segments by seeking through the query bitmap and
       // probing each ID interval.
       std::vector<uuid const*> candidates;
-      auto ones = select(bm);
+      bitmap_skip_index ids{bm};
+      auto id = ids.select(1);
       auto i = self->state.segments.begin();
       auto end = self->state.segments.end();
-      while (ones && i != end) {
-        if (ones.get() < i->left) {
+      while (id != invalid_event_id && i != end) {
+        if (id < i->left) {
           // Bitmap must catch up, segment is ahead.
-          ones.skip(i->left - ones.get());
-        } else if (ones.get() < i->right) {
+          id = ids.find_next(i->left - 1);
+        } else if (id < i->right) {
           // Match: bitmap is within an existing segment.
           candidates.push_back(&i->value);
-          ones.skip(i->right - ones.get());
+          id = ids.find_next(i->right - 1);
           ++i;
         } else {
           // Segment must catch up, bitmap is ahead.
@@ -273,7 +280,7 @@ archive(archive_type::stateful_pointer<archive_state> self,
         }
         // Perform lookup in segment and append extracted events to result.
         VAST_ASSERT(s != nullptr);
-        auto xs = s->extract(bm);
+        auto xs = s->extract(ids);
         if (!xs) {
           VAST_ERROR(self, self->system().render(xs.error()));
           rp.deliver(xs.error());
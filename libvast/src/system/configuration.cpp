@@ -13,6 +13,7 @@
 #include "vast/bitmap.hpp"
 #include "vast/error.hpp"
 #include "vast/event.hpp"
+#include "vast/event_slice.hpp"
 #include "vast/expression.hpp"
 #include "vast/operator.hpp"
 #include "vast/query_options.hpp"
@@ -22,6 +23,7 @@
 #include "vast/uuid.hpp"
 
 #include "vast/system/configuration.hpp"
+#include "vast/system/partition.hpp"
 #include "vast/system/replicated_store.hpp"
 #include "vast/system/query_statistics.hpp"
 #include "vast/system/tracker.hpp"
@@ -37,6 +39,7 @@ configuration::configuration() {
   add_message_type<bitmap>("vast::bitmap");
   add_message_type<data>("vast::data");
   add_message_type<event>("vast::event");
+  add_message_type<event_slice>("vast::event_slice");
   add_message_type<expression>("vast::expression");
   add_message_type<query_options>("vast::query_options");
   add_message_type<relational_operator>("vast::relational_operator");
@@ -49,6 +52,7 @@ configuration::configuration() {
   // Actor-specific messages
   add_message_type<component_map>("vast::system::component_map");
   add_message_type<component_map_entry>("vast::system::component_map_entry");
+  add_message_type<group_counts>("vast::system::group_counts");
   add_message_type<registry>("vast::system::registry");
   add_message_type<query_statistics>("vast::system::query_statistics");
   add_message_type<actor_identity>("vast::system::actor_identity");
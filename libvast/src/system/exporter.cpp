@@ -1,13 +1,17 @@
+#include <algorithm>
+#include <iterator>
+
 #include <caf/all.hpp>
 
 #include "vast/event.hpp"
 #include "vast/logger.hpp"
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/key.hpp"
 #include "vast/concept/printable/std/chrono.hpp"
 #include "vast/concept/printable/vast/event.hpp"
 #include "vast/concept/printable/vast/expression.hpp"
 #include "vast/concept/printable/vast/uuid.hpp"
 #include "vast/detail/assert.hpp"
-#include "vast/expression_visitors.hpp"
 
 #include "vast/system/archive.hpp"
 #include "vast/system/atoms.hpp"
@@ -22,6 +26,44 @@ namespace system {
 
 namespace {
 
+// Checks whether the index answers an expression without false positives.
+// Time values and reals live in binned indexes, the string index chops long
+// strings, and some operators have no index support at all. Hits for such
+// predicates are mere candidates.
+struct exactness_checker {
+  bool operator()(none) const {
+    return true;
+  }
+
+  bool operator()(conjunction const& c) const {
+    return std::all_of(c.begin(), c.end(),
+                       [&](auto& x) { return visit(*this, x); });
+  }
+
+  bool operator()(disjunction const& d) const {
+    return std::all_of(d.begin(), d.end(),
+                       [&](auto& x) { return visit(*this, x); });
+  }
+
+  bool operator()(negation const& n) const {
+    return visit(*this, n.expr());
+  }
+
+  bool operator()(predicate const& p) const {
+    if (auto a = get_if<attribute_extractor>(p.lhs))
+      return a->attr == "type";
+    auto d = get_if<data>(p.rhs);
+    if (!d)
+      return false;
+    if (auto str = get_if<std::string>(*d))
+      // Strings up to the default maximum length of a string_index.
+      return (p.op == equal || p.op == not_equal) && str->size() < 1024;
+    return is<boolean>(*d) || is<integer>(*d) || is<count>(*d)
+           || is<address>(*d) || is<subnet>(*d) || is<port>(*d);
+  }
+};
+
+
 void ship_results(stateful_actor<exporter_state>* self) {
   if (self->state.results.empty() || self->state.stats.requested == 0)
     return;
@@ -46,9 +88,36 @@ void ship_results(stateful_actor<exporter_state>* self) {
   self->send(self->state.sink, msg);
 }
 
-void shutdown(stateful_actor<exporter_state>* self) {
-  if (rank(self->state.unprocessed) > 0 || !self->state.results.empty())
+// Adds a result after projecting it onto the selected fields, if any.
+void add_result(stateful_actor<exporter_state>* self, event&& e) {
+  if (self->state.project.empty()) {
+    self->state.results.push_back(std::move(e));
     return;
+  }
+  if (auto x = self->state.project(e))
+    self->state.results.push_back(std::move(*x));
+  else
+    VAST_DEBUG(self, "drops result without selected fields:", e);
+}
+
+bool limit_reached(stateful_actor<exporter_state>* self) {
+  return self->state.limit > 0
+         && self->state.stats.shipped >= self->state.limit;
+}
+
+void shutdown(stateful_actor<exporter_state>* self) {
+  if (!limit_reached(self)) {
+    if (rank(self->state.unprocessed) > 0 || rank(self->state.pending) > 0
+        || !self->state.results.empty())
+      return;
+    // Continuous queries keep running after the historical part completes.
+    if (has_continuous_option(self->state.options))
+      return;
+  } else if (self->state.stats.received < self->state.stats.expected) {
+    VAST_DEBUG(self, "cancels lookup after reaching limit of",
+               self->state.limit, "results");
+    self->send(self->state.index, self->state.id, size_t{0});
+  }
   timespan runtime = steady_clock::now() - self->state.start;
   self->state.stats.runtime = runtime;
   VAST_DEBUG(self, "completed in", runtime);
@@ -69,11 +138,84 @@ void shutdown(stateful_actor<exporter_state>* self) {
   self->send_exit(self, exit_reason::normal);
 }
 
+// Brings the results that arrived after the first *buffered* ones into time
+// order and merges them with the buffered results, which are already in order.
+void merge_results(stateful_actor<exporter_state>* self, size_t buffered) {
+  auto& xs = self->state.results;
+  auto mid = xs.begin() + buffered;
+  auto merge = [&](auto cmp) {
+    std::stable_sort(mid, xs.end(), cmp);
+    std::inplace_merge(xs.begin(), mid, xs.end(), cmp);
+  };
+  if (has_oldest_first_option(self->state.options))
+    merge([](event const& x, event const& y) {
+      return x.timestamp() < y.timestamp();
+    });
+  else
+    merge([](event const& x, event const& y) {
+      return x.timestamp() > y.timestamp();
+    });
+}
+
+// Ensures that the outstanding extraction requests do not exceed the limit.
+void apply_limit(stateful_actor<exporter_state>* self) {
+  if (self->state.limit == 0)
+    return;
+  auto shipped = std::min(self->state.stats.shipped, self->state.limit);
+  self->state.stats.requested =
+    std::min(self->state.stats.requested, self->state.limit - shipped);
+}
+
+// Forwards pending index hits to the archive, but only as many as we need to
+// satisfy the outstanding extraction requests. Each hit yields at most one
+// result, so we count candidates in flight and buffered results against the
+// request.
+void forward_hits(stateful_actor<exporter_state>* self) {
+  auto pending = rank(self->state.pending);
+  if (pending == 0)
+    return;
+  // Under a limit, we only forward the most recent (or oldest) hits.
+  // Partitions answer in any order, so a partition still running may hold
+  // hits that come first. We decide once all scheduled partitions answered.
+  if (self->state.limit > 0
+      && self->state.stats.received < self->state.stats.scheduled)
+    return;
+  auto have = self->state.results.size() + rank(self->state.unprocessed);
+  if (self->state.stats.requested <= have)
+    return;
+  auto n = self->state.stats.requested - have;
+  bitmap hits;
+  if (n >= pending) {
+    hits = std::move(self->state.pending);
+    self->state.pending = {};
+  } else if (has_oldest_first_option(self->state.options)) {
+    // Cut the pending hits right after the n-th one.
+    bitmap prefix;
+    prefix.append_bits(true, select(self->state.pending, n) + 1);
+    hits = self->state.pending & prefix;
+    self->state.pending -= prefix;
+  } else {
+    // Since IDs grow over time, the most recent hits come last. We cut the
+    // pending hits right before the n-th one from the end.
+    bitmap prefix;
+    prefix.append_bits(true, select(self->state.pending, pending - n + 1));
+    hits = self->state.pending - prefix;
+    self->state.pending &= prefix;
+  }
+  VAST_DEBUG(self, "forwards", rank(hits), "of", pending, "hits to archive");
+  self->state.unprocessed |= hits;
+  self->send(self->state.archive, std::move(hits));
+}
+
 void request_more_hits(stateful_actor<exporter_state>* self) {
+  if (!has_historical_option(self->state.options) || limit_reached(self))
+    return;
   auto waiting_for_hits =
     self->state.stats.received == self->state.stats.scheduled;
-  auto need_more_results = self->state.stats.requested > 0;
-  auto have_no_inflight_requests = any<1>(self->state.unprocessed);
+  auto need_more_results =
+    self->state.stats.requested > self->state.results.size();
+  auto have_no_inflight_requests = !any<1>(self->state.unprocessed)
+                                   && !any<1>(self->state.pending);
   // If we're (1) no longer waiting for index hits, (2) still need more
   // results, and (3) have no inflight requests to the archive, we ask
   // the index for more hits.
@@ -83,13 +225,104 @@ void request_more_hits(stateful_actor<exporter_state>* self) {
     auto n = std::min(remaining, size_t{2});
     VAST_DEBUG(self, "asks index to process", n, "more partitions");
     self->send(self->state.index, self->state.id, n);
+    self->state.stats.scheduled += n;
+  }
+}
+
+// Turns the hits of an aggregate query into result events. A plain count
+// yields a single event, a grouped count one event per group.
+void make_aggregates(stateful_actor<exporter_state>* self) {
+  auto now = timestamp::clock::now();
+  auto add = [&](auto&& x, type const& t) {
+    auto e = event::make(std::move(x), t);
+    e.timestamp(now);
+    self->state.results.push_back(std::move(e));
+  };
+  if (self->state.group.empty()) {
+    auto t = record_type{{"count", count_type{}}}.name("vast::count");
+    auto n = self->state.verify ? self->state.matched : rank(self->state.hits);
+    add(vector{count{n}}, t);
+  } else {
+    auto t = record_type{
+      {"group", string_type{}},
+      {"count", count_type{}}
+    }.name("vast::group");
+    for (auto& x : self->state.counts)
+      add(vector{x.first, count{x.second}}, t);
+  }
+}
+
+// Counts a result of an aggregate query after the candidate check.
+expected<void> tally(stateful_actor<exporter_state>* self, event const& e) {
+  auto& group = self->state.group;
+  if (group.empty()) {
+    ++self->state.matched;
+    return no_error;
+  }
+  if (group == "&type") {
+    ++self->state.counts[e.type().name()];
+    return no_error;
+  }
+  auto r = get_if<record_type>(e.type());
+  auto xs = get_if<vector>(e.data());
+  if (!r || !xs)
+    return no_error;
+  auto k = to<key>(group);
+  VAST_ASSERT(k);
+  for (auto& x : r->find_suffix(*k)) {
+    if (!is<boolean_type>(*r->at(x.first)))
+      return make_error(ec::type_clash, "cannot group by non-boolean field",
+                        group);
+    if (auto b = get_if<boolean>(get(*xs, x.first)))
+      ++self->state.counts[*b ? "T" : "F"];
+  }
+  return no_error;
+}
+
+// Ships the counts of a verified aggregate query once all candidates have
+// gone through the candidate check.
+void complete_verification(stateful_actor<exporter_state>* self) {
+  if (self->state.stats.received < self->state.stats.expected
+      || any<1>(self->state.pending) || any<1>(self->state.unprocessed))
+    return;
+  make_aggregates(self);
+  ship_results(self);
+  shutdown(self);
+}
+
+// Accounts for the answer of one partition. Once all partitions have
+// answered, the lookup is complete.
+void complete_partition(stateful_actor<exporter_state>* self,
+                        timespan runtime) {
+  ++self->state.stats.received;
+  self->send(self->state.sink, self->state.id, self->state.stats);
+  forward_hits(self);
+  if (self->state.stats.received < self->state.stats.expected) {
+    VAST_DEBUG(self, "received", self->state.stats.received << '/'
+                                 << self->state.stats.expected, "bitmaps");
+    request_more_hits(self);
+  } else {
+    VAST_DEBUG(self, "received all", self->state.stats.expected,
+               "bitmap(s) in", runtime);
+    if (self->state.accountant)
+      self->send(self->state.accountant, "exporter.hits.runtime", runtime);
+    if (self->state.verify) {
+      complete_verification(self);
+      return;
+    }
+    if (self->state.aggregate) {
+      make_aggregates(self);
+      ship_results(self);
+    }
+    shutdown(self);
   }
 }
 
 } // namespace <anonymous>
 
 behavior exporter(stateful_actor<exporter_state>* self, expression expr,
-                  query_options) {
+                  query_options opts) {
+  self->state.options = opts;
   auto eu = self->system().dummy_execution_unit();
   self->state.sink = actor_pool::make(eu, actor_pool::broadcast());
   if (auto a = self->system().registry().get(accountant_atom::value))
@@ -101,6 +334,13 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
       self->quit(msg.reason);
     }
   );
+  // Partitions report errors, e.g., an invalid group key, as a response.
+  self->set_error_handler(
+    [=](error& e) {
+      VAST_ERROR(self, "aborts query:", self->system().render(e));
+      self->send_exit(self, std::move(e));
+    }
+  );
   return {
     [=](bitmap& hits) {
       timespan runtime = steady_clock::now() - self->state.start;
@@ -117,34 +357,35 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
                                      + to_string(select(hits, -1) + 1) + ')')));
       if (count > 0) {
         self->state.hits |= hits;
-        self->state.unprocessed |= hits;
-        VAST_DEBUG(self, "forwards hits to archive");
-        // FIXME: restrict according to configured limit.
-        self->send(self->state.archive, std::move(hits));
-      }
-      // Figure out if we're done.
-      ++self->state.stats.received;
-      self->send(self->state.sink, self->state.id, self->state.stats);
-      if (self->state.stats.received < self->state.stats.expected) {
-        VAST_DEBUG(self, "received", self->state.stats.received << '/'
-                                     << self->state.stats.expected, "bitmaps");
-        request_more_hits(self);
-      } else {
-        VAST_DEBUG(self, "received all", self->state.stats.expected,
-                   "bitmap(s) in", runtime);
-        if (self->state.accountant)
-          self->send(self->state.accountant, "exporter.hits.runtime", runtime);
-        shutdown(self);
+        // Aggregate queries never need to look at the events themselves.
+        if (!self->state.aggregate || self->state.verify)
+          self->state.pending |= hits;
       }
+      complete_partition(self, runtime);
+    },
+    [=](group_counts& counts) {
+      timespan runtime = steady_clock::now() - self->state.start;
+      self->state.stats.runtime = runtime;
+      VAST_DEBUG(self, "got counts for", counts.size(), "groups");
+      for (auto& x : counts)
+        self->state.counts[x.first] += x.second;
+      complete_partition(self, runtime);
     },
     [=](std::vector<event>& candidates) {
       VAST_DEBUG(self, "got batch of", candidates.size(), "events");
-      bitmap mask;
-      for (auto& candidate : candidates) {
-        auto& checker = self->state.checkers[candidate.type()];
+      // Check the candidates in runs of the same type, so that each checker
+      // processes as many events at once as possible.
+      std::vector<uint8_t> selected;
+      selected.reserve(candidates.size());
+      auto first = candidates.begin();
+      while (first != candidates.end()) {
+        auto& t = first->type();
+        auto last = std::find_if(first + 1, candidates.end(),
+                                 [&](event const& e) { return e.type() != t; });
+        auto& checker = self->state.checkers[t];
         // Construct a candidate checker if we don't have one for this type.
-        if (is<none>(checker)) {
-          auto x = tailor(expr, candidate.type());
+        if (!checker) {
+          auto x = make_checker(expr, t);
           if (!x) {
             VAST_ERROR(self, "failed to tailor expression:",
                        self->system().render(x.error()));
@@ -153,21 +394,57 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
             return;
           }
           checker = std::move(*x);
-          VAST_DEBUG(self, "tailored AST to", candidate.type() << ':', checker);
+          VAST_DEBUG(self, "tailored AST to", t << ':', checker.expr());
         }
-        // Perform candidate check and keep event as result on success.
-        if (visit(event_evaluator{candidate}, checker))
-          self->state.results.push_back(std::move(candidate));
-        else
-          VAST_DEBUG(self, "ignores false positive:", candidate);
-        mask.append_bits(false, candidate.id() - mask.size());
-        mask.append_bit(true);
+        checker(&*first, static_cast<size_t>(last - first), selected);
+        first = last;
+      }
+      // Keep events as results on success and mark all candidates as
+      // processed. The archive delivers its segments in reverse, so the IDs
+      // only ascend within a segment. We sort the IDs and append contiguous
+      // runs to the mask as a whole.
+      auto buffered = self->state.results.size();
+      std::vector<event_id> ids;
+      ids.reserve(candidates.size());
+      for (size_t i = 0; i < candidates.size(); ++i) {
+        ids.push_back(candidates[i].id());
+        if (!selected[i]) {
+          VAST_DEBUG(self, "ignores false positive:", candidates[i]);
+        } else if (!self->state.verify) {
+          add_result(self, std::move(candidates[i]));
+        } else {
+          auto r = tally(self, candidates[i]);
+          if (!r) {
+            VAST_ERROR(self, self->system().render(r.error()));
+            self->send_exit(self, std::move(r.error()));
+            return;
+          }
+        }
+      }
+      std::sort(ids.begin(), ids.end());
+      ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+      bitmap mask;
+      for (size_t i = 0; i < ids.size(); ) {
+        auto j = i + 1;
+        while (j < ids.size() && ids[j] == ids[i] + (j - i))
+          ++j;
+        mask.append_bits(false, ids[i] - mask.size());
+        mask.append_bits(true, j - i);
+        i = j;
       }
+      merge_results(self, buffered);
       self->state.stats.processed += candidates.size();
       self->state.unprocessed -= mask;
       ship_results(self);
+      if (limit_reached(self)) {
+        shutdown(self);
+        return;
+      }
+      forward_hits(self);
       request_more_hits(self);
-      if (self->state.stats.received == self->state.stats.expected)
+      if (self->state.verify)
+        complete_verification(self);
+      else if (self->state.stats.received == self->state.stats.expected)
         shutdown(self);
     },
     [=](extract_atom) {
@@ -176,7 +453,9 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
         return;
       }
       self->state.stats.requested = max_events;
+      apply_limit(self);
       ship_results(self);
+      forward_hits(self);
       request_more_hits(self);
     },
     [=](extract_atom, uint64_t requested) {
@@ -188,7 +467,40 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
       self->state.stats.requested += n;
       VAST_DEBUG(self, "got request to extract", n, "new events in addition to",
                  self->state.stats.requested, "pending results");
+      apply_limit(self);
+      ship_results(self);
+      forward_hits(self);
+      request_more_hits(self);
+    },
+    [=](count_atom) {
+      VAST_DEBUG(self, "counts results instead of extracting them");
+      self->state.aggregate = true;
+    },
+    [=](count_atom, std::string& group) {
+      VAST_DEBUG(self, "counts results grouped by", group);
+      self->state.aggregate = true;
+      self->state.group = std::move(group);
+    },
+    [=](project_atom, std::vector<std::string> const& fields) {
+      std::vector<key> keys;
+      for (auto& field : fields) {
+        auto k = to<key>(field);
+        if (!k) {
+          VAST_ERROR(self, "ignores invalid projection key:", field);
+          continue;
+        }
+        keys.push_back(std::move(*k));
+      }
+      VAST_DEBUG(self, "projects results onto", keys.size(), "keys");
+      self->state.project = projection{std::move(keys)};
+    },
+    [=](limit_atom, uint64_t max) {
+      VAST_DEBUG(self, "caps results at", max, "events");
+      self->state.limit = max;
+      self->state.stats.requested = max_events;
+      apply_limit(self);
       ship_results(self);
+      forward_hits(self);
       request_more_hits(self);
     },
     [=](archive_type const& archive) {
@@ -199,6 +511,29 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
       VAST_DEBUG(self, "registers index", index);
       self->state.index = index;
     },
+    [=](continuous_atom, std::vector<event>& matches) {
+      VAST_DEBUG(self, "got", matches.size(), "continuous matches");
+      self->state.stats.processed += matches.size();
+      for (auto& x : matches)
+        add_result(self, std::move(x));
+      ship_results(self);
+      if (limit_reached(self))
+        shutdown(self);
+    },
+    [=](matcher_atom, actor const& matcher) {
+      if (!has_continuous_option(opts))
+        return;
+      VAST_DEBUG(self, "subscribes at stream matcher", matcher);
+      self->request(matcher, infinite, subscribe_atom::value, expr).then(
+        [=](ok_atom) {
+          VAST_DEBUG(self, "subscribed at stream matcher", matcher);
+        },
+        [=](error const& e) {
+          VAST_ERROR(self, "failed to subscribe at stream matcher:",
+                     self->system().render(e));
+        }
+      );
+    },
     [=](sink_atom, actor const& sink) {
       VAST_DEBUG(self, "registers index", sink);
       self->send(self->state.sink, sys_atom::value, put_atom::value, sink);
@@ -206,7 +541,20 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
     [=](run_atom) {
       VAST_INFO(self, "executes query", expr);
       self->state.start = steady_clock::now();
-      self->request(self->state.index, infinite, expr).then(
+      if (!has_historical_option(opts))
+        return;
+      // Counting the index hits only works if they contain no false
+      // positives. Otherwise we take the hits through the candidate check.
+      if (self->state.aggregate && self->state.archive
+          && !visit(exactness_checker{}, expr)) {
+        VAST_DEBUG(self, "verifies candidates of inexact expression");
+        self->state.verify = true;
+        self->state.stats.requested = max_events;
+      }
+      auto msg = self->state.group.empty() || self->state.verify
+        ? make_message(expr, opts)
+        : make_message(expr, opts, group_atom::value, self->state.group);
+      self->request(self->state.index, infinite, std::move(msg)).then(
         [=](const uuid& lookup, size_t partitions, size_t scheduled) {
           VAST_DEBUG(self, "got lookup handle", lookup << ", scheduled",
                      scheduled << '/' << partitions, "partitions");
@@ -215,6 +563,11 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
             self->state.stats.expected = partitions;
             self->state.stats.scheduled = scheduled;
           } else {
+            // Without any qualifying partition, aggregates are still due.
+            if (self->state.aggregate) {
+              make_aggregates(self);
+              ship_results(self);
+            }
             shutdown(self);
           }
         },
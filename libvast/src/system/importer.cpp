@@ -64,69 +64,146 @@ auto shutdown(stateful_actor<importer_state>* self) {
     write_state(self);
     self->anon_send(self->state.archive, sys_atom::value, delete_atom::value);
     self->anon_send(self->state.index, sys_atom::value, delete_atom::value);
+    self->anon_send(self->state.matcher, sys_atom::value, delete_atom::value);
     self->send_exit(self->state.archive, msg.reason);
     self->send_exit(self->state.index, msg.reason);
+    self->send_exit(self->state.matcher, msg.reason);
     self->quit(msg.reason);
   };
 }
 
-// Ships a batch of events to archive and index.
-void ship(stateful_actor<importer_state>* self, std::vector<event>&& batch) {
+// Ships a batch of events to archive and index and invokes *f* after both
+// have acknowledged it.
+template <class F>
+void ship(stateful_actor<importer_state>* self, std::vector<event>&& batch,
+          F f) {
   VAST_ASSERT(batch.size() <= self->state.available);
   for (auto& e : batch)
     e.id(self->state.next++);
   self->state.available -= batch.size();
   VAST_DEBUG(self, "ships", batch.size(), "events");
-  // TODO: How to retain type safety without copying the entire batch?
-  auto msg = make_message(std::move(batch));
-  self->send(actor_cast<actor>(self->state.archive), msg);
-  self->send(self->state.index, msg);
+  // Archive and index share the same immutable events.
+  auto slice = event_slice{std::move(batch)};
+  auto n = std::make_shared<size_t>(2);
+  auto ack = [=]() mutable {
+    if (--*n == 0)
+      f();
+  };
+  auto fail = [=](error const& e) mutable {
+    VAST_ERROR(self, "failed to ship events:", self->system().render(e));
+    ack();
+  };
+  self->request(self->state.archive, infinite, slice).then(
+    [=](ok_atom) mutable { ack(); },
+    fail
+  );
+  self->request(self->state.index, infinite, slice).then(
+    [=](ok_atom) mutable { ack(); },
+    fail
+  );
+  // Continuous queries see the events right away and do not hold back the
+  // acknowledgement.
+  self->send(self->state.matcher, slice);
+}
+
+// Assigns IDs to buffered batches and ships them, as long as we have IDs.
+void drain(stateful_actor<importer_state>* self) {
+  auto& st = self->state;
+  while (!st.backlog.empty()) {
+    if (st.available == 0) {
+      if (st.prefetched == 0)
+        break;
+      VAST_DEBUG(self, "switches to prefetched lease of", st.prefetched,
+                 "IDs starting at", st.prefetched_next);
+      st.next = st.prefetched_next;
+      st.available = st.prefetched;
+      st.prefetched = 0;
+    }
+    auto& front = st.backlog.front();
+    if (front.events.size() <= st.available) {
+      auto rp = front.promise;
+      ship(self, std::move(front.events),
+           [=]() mutable { rp.deliver(ok_atom::value); });
+      st.backlog.pop_front();
+    } else {
+      // Ship what the current lease covers. The rest stays at the front of
+      // the backlog and carries the acknowledgement.
+      auto n = static_cast<std::ptrdiff_t>(st.available);
+      std::vector<event> head(std::make_move_iterator(front.events.begin()),
+                              std::make_move_iterator(front.events.begin()
+                                                      + n));
+      front.events.erase(front.events.begin(), front.events.begin() + n);
+      ship(self, std::move(head), [] {});
+    }
+  }
 }
 
-// Asks the metastore for more IDs.
-void replenish(stateful_actor<importer_state>* self) {
+// Asks the meta store for the next lease of IDs before the current one runs
+// out. The request is asynchronous so that shipping never waits for a
+// consensus round-trip, unless we have exhausted both current and prefetched
+// lease. Since the meta store hands out disjoint ranges, multiple importers
+// can lease IDs concurrently.
+void prefetch(stateful_actor<importer_state>* self) {
+  auto& st = self->state;
+  if (st.leasing || st.prefetched > 0 || !st.meta_store)
+    return;
+  auto buffered = size_t{0};
+  for (auto& x : st.backlog)
+    buffered += x.events.size();
+  auto running_low = st.available < st.batch_size / 2;
+  if (!running_low && buffered == 0)
+    return;
   auto now = steady_clock::now();
-  if (now - self->state.last_replenish < 10s) {
-    VAST_DEBUG(self, "had to replenish twice within 10 secs");
-    VAST_DEBUG(self, "doubles batch size:", self->state.batch_size,
-                    "->", self->state.batch_size * 2);
-    self->state.batch_size *= 2;
+  if (now - st.last_replenish < 10s) {
+    VAST_DEBUG(self, "had to lease twice within 10 secs");
+    VAST_DEBUG(self, "doubles lease size:", st.batch_size,
+                    "->", st.batch_size * 2);
+    st.batch_size *= 2;
   }
-  if (self->state.remainder.size() > self->state.batch_size) {
-    VAST_DEBUG(self, "raises batch size to buffered events:",
-               self->state.batch_size, "->", self->state.remainder.size());
-    self->state.batch_size = self->state.remainder.size();
+  if (buffered > st.batch_size) {
+    VAST_DEBUG(self, "raises lease size to buffered events:",
+               st.batch_size, "->", buffered);
+    st.batch_size = buffered;
   }
-  self->state.last_replenish = now;
-  VAST_DEBUG(self, "replenishes", self->state.batch_size, "IDs");
-  VAST_ASSERT(max_event_id - self->state.next >= self->state.batch_size);
-  auto n = self->state.batch_size;
-  // If we get an EXIT message while expecting a response from the metastore,
-  // we'll give it a bit of time to come back;
+  st.last_replenish = now;
+  VAST_DEBUG(self, "leases", st.batch_size, "IDs");
+  VAST_ASSERT(max_event_id - st.next >= st.batch_size);
+  auto n = st.batch_size;
+  st.leasing = true;
+  // If we get an EXIT message while waiting for the meta store, we give it a
+  // bit of time to come back.
   self->set_exit_handler(
-    [=](const exit_msg& msg) {
+    [=](exit_msg const& msg) {
       self->delayed_send(self, 5s, msg);
       self->set_exit_handler(shutdown(self));
     }
   );
-  self->send(self->state.meta_store, add_atom::value, "id", data{n});
-  self->become(
-    keep_behavior,
-    [=](const data& old) {
+  self->request(st.meta_store, infinite, add_atom::value, "id", data{n}).then(
+    [=](data const& old) {
       auto x = is<none>(old) ? count{0} : get<count>(old);
       VAST_DEBUG(self, "got", n, "new IDs starting at", x);
-      self->state.available = n;
-      self->state.next = x;
-      if (!self->state.remainder.empty())
-        ship(self, std::move(self->state.remainder));
+      self->state.leasing = false;
+      self->set_exit_handler(shutdown(self));
+      if (self->state.available == 0) {
+        self->state.next = x;
+        self->state.available = n;
+      } else {
+        self->state.prefetched_next = x;
+        self->state.prefetched = n;
+      }
       auto result = write_state(self);
       if (!result) {
         VAST_ERROR(self, "failed to save state:",
                    self->system().render(result.error()));
         self->quit(result.error());
+        return;
       }
-      self->set_exit_handler(shutdown(self));
-      self->unbecome();
+      drain(self);
+      prefetch(self);
+    },
+    [=](error const& e) {
+      VAST_ERROR(self, "failed to lease IDs:", self->system().render(e));
+      self->quit(e);
     }
   );
 }
@@ -148,6 +225,7 @@ behavior importer(stateful_actor<importer_state>* self, path dir,
   auto eu = self->system().dummy_execution_unit();
   self->state.archive = actor_pool::make(eu, actor_pool::round_robin());
   self->state.index = actor_pool::make(eu, actor_pool::round_robin());
+  self->state.matcher = actor_pool::make(eu, actor_pool::broadcast());
   self->set_default_handler(skip);
   self->set_exit_handler(shutdown(self));
   self->set_down_handler(
@@ -172,6 +250,11 @@ behavior importer(stateful_actor<importer_state>* self, path dir,
       VAST_DEBUG(self, "registers index", index);
       self->send(self->state.index, sys_atom::value, put_atom::value, index);
     },
+    [=](matcher_atom, actor const& matcher) {
+      VAST_DEBUG(self, "registers stream matcher", matcher);
+      self->send(self->state.matcher, sys_atom::value, put_atom::value,
+                 matcher);
+    },
     [=](std::vector<event>& events) {
       VAST_ASSERT(!events.empty());
       VAST_DEBUG(self, "got", events.size(), "events");
@@ -180,24 +263,12 @@ behavior importer(stateful_actor<importer_state>* self, path dir,
         self->quit(make_error(ec::unspecified, "no meta store configured"));
         return;
       }
-      if (events.size() <= self->state.available) {
-        // Ship the events immediately if we have enough IDs.
-        ship(self, std::move(events));
-      } else if (self->state.available > 0) {
-        // Ship a subset if we have any IDs left.
-        auto remainder = std::vector<event>(
-          std::make_move_iterator(events.begin() + self->state.available),
-          std::make_move_iterator(events.end()));
-        events.resize(self->state.available);
-        ship(self, std::move(events));
-        self->state.remainder = std::move(remainder);
-      } else {
-        // Buffer events otherwise.
-        self->state.remainder = std::move(events);
-      }
-      auto running_low = self->state.available < self->state.batch_size * 0.1;
-      if (running_low || !self->state.remainder.empty())
-        replenish(self);
+      // We acknowledge a batch after archive and index have processed all of
+      // its events. Sources use this to limit their in-flight batches.
+      self->state.backlog.push_back({std::move(events),
+                                     self->make_response_promise()});
+      drain(self);
+      prefetch(self);
     }
   };
 }
@@ -1,4 +1,8 @@
+#include <algorithm>
 #include <deque>
+#include <fstream>
+#include <numeric>
+#include <tuple>
 #include <unordered_set>
 
 #include <caf/all.hpp>
@@ -17,6 +21,7 @@
 #include "vast/save.hpp"
 
 #include "vast/system/accountant.hpp"
+#include "vast/system/atoms.hpp"
 #include "vast/system/index.hpp"
 #include "vast/system/partition.hpp"
 #include "vast/system/task.hpp"
@@ -29,7 +34,10 @@ using namespace caf;
 namespace vast {
 namespace system {
 
-void partition_index::add(const std::vector<event> xs, const uuid& partition) {
+const index_state::magic_type index_state::magic;
+const index_state::version_type index_state::version;
+
+void partition_index::add(const event_slice& xs, const uuid& partition) {
   // Compute span of events.
   auto bound = [](const interval& a, const interval& b) -> interval {
     return {std::min(a.from, b.from), std::max(a.to, b.to)};
@@ -45,10 +53,18 @@ void partition_index::add(const std::vector<event> xs, const uuid& partition) {
 }
 
 std::vector<uuid> partition_index::lookup(const expression& expr) const {
-  std::vector<uuid> result;
+  std::vector<std::pair<interval, uuid>> xs;
   for (auto& x : partitions_)
     if (visit(time_restrictor{x.second.range.from, x.second.range.to}, expr))
-      result.push_back(x.first);
+      xs.emplace_back(x.second.range, x.first);
+  std::sort(xs.begin(), xs.end(), [](auto& x, auto& y) {
+    return std::tie(x.first.to, x.first.from, x.second)
+           < std::tie(y.first.to, y.first.from, y.second);
+  });
+  std::vector<uuid> result;
+  result.reserve(xs.size());
+  for (auto& x : xs)
+    result.push_back(x.second);
   return result;
 }
 
@@ -68,6 +84,14 @@ void evict(stateful_actor<index_state>* self) {
   }
 }
 
+// Sends the expression of a lookup to a partition on behalf of its sink.
+void dispatch(const lookup_state& ctx, const actor& partition) {
+  if (ctx.group.empty())
+    send_as(ctx.sink, partition, ctx.expr);
+  else
+    send_as(ctx.sink, partition, ctx.expr, group_atom::value, ctx.group);
+}
+
 // FIXME: erase lookups that have completed.
 void schedule(stateful_actor<index_state>* self, const uuid& part,
               const uuid& lookup) {
@@ -75,14 +99,14 @@ void schedule(stateful_actor<index_state>* self, const uuid& part,
   // If we're dealing with the active partition, we dispatch immediately.
   if (part == self->state.active.id) {
     VAST_DEBUG(self, "dispatches to active partition", part);
-    send_as(ctx.sink, self->state.active.partition, ctx.expr);
+    dispatch(ctx, self->state.active.partition);
     return;
   }
   // If the partition is loaded, we can also dispatch immediately.
   auto l = self->state.loaded.find(part);
   if (l != self->state.loaded.end()) {
     VAST_DEBUG(self, "dispatches to loaded partition", part);
-    send_as(ctx.sink, l->second, ctx.expr);
+    dispatch(ctx, l->second);
     return;
   }
   // If we have enough room, we can spin up the next partition.
@@ -92,7 +116,7 @@ void schedule(stateful_actor<index_state>* self, const uuid& part,
     auto part_dir = self->state.dir / to_string(part);
     auto p = self->spawn<monitored>(partition, std::move(part_dir));
     self->state.loaded.emplace(part, p);
-    send_as(ctx.sink, p, ctx.expr);
+    dispatch(ctx, p);
     return;
   }
   // If we're full, we delay dispatching until having evicted a partition.
@@ -109,6 +133,23 @@ void schedule(stateful_actor<index_state>* self, const uuid& part,
   }
 }
 
+// Removes a lookup along with all queued partitions where it was the only
+// lookup. Partitions that already run deliver their hits nonetheless.
+void cancel(stateful_actor<index_state>* self, const uuid& lookup) {
+  for (auto& x : self->state.scheduled)
+    if (x.lookups.size() > 1)
+      x.lookups.erase(lookup);
+  auto is_only_lookup = [&](auto& x) {
+    return x.lookups.size() == 1 && x.lookups.count(lookup) > 0;
+  };
+  auto i = std::remove_if(self->state.scheduled.begin(),
+                          self->state.scheduled.end(), is_only_lookup);
+  auto n = self->state.scheduled.end() - i;
+  VAST_DEBUG(self, "erases", n, "scheduled lookups");
+  self->state.scheduled.erase(i, self->state.scheduled.end());
+  self->state.lookups.erase(lookup);
+}
+
 // FIXME: erase lookups that have completed.
 void unschedule(stateful_actor<index_state>* self, const actor& part) {
   // Check if we got an evicted partition.
@@ -128,7 +169,7 @@ void unschedule(stateful_actor<index_state>* self, const actor& part) {
         VAST_ASSERT(self->state.lookups.count(id) > 0);
         auto& ctx = self->state.lookups[id];
         VAST_DEBUG(self, "dispatches expression", ctx.expr);
-        send_as(ctx.sink, p, ctx.expr);
+        dispatch(ctx, p);
       }
       self->state.scheduled.pop_front();
       // If we have more pending partitions, try to evict more.
@@ -153,7 +194,19 @@ behavior index(stateful_actor<index_state>* self, const path& dir,
     accountant = actor_cast<accountant_type>(a);
   // Read persistent state.
   if (exists(self->state.dir / "meta")) {
-    auto result = load(self->state.dir / "meta", self->state.part_index);
+    // Check the format before touching the payload: databases written before
+    // the index carried a version have no magic.
+    std::ifstream fs{(self->state.dir / "meta").str()};
+    index_state::magic_type m = 0;
+    index_state::version_type v = 0;
+    auto result = load(fs, m, v);
+    if (result && m != index_state::magic)
+      result = make_error(ec::version_error, "unversioned index requires",
+                          "re-import:", self->state.dir);
+    else if (result && v < index_state::version)
+      result = make_error(ec::version_error, v, index_state::version);
+    if (result)
+      result = load(fs, self->state.part_index);
     if (!result) {
       VAST_ERROR(self, "failed to load partition index:",
                  self->system().render(result.error()));
@@ -199,8 +252,8 @@ behavior index(stateful_actor<index_state>* self, const path& dir,
             return;
           }
         }
-        auto result = save(self->state.dir / "meta",
-                           self->state.part_index);
+        auto result = save(self->state.dir / "meta", index_state::magic,
+                           index_state::version, self->state.part_index);
         if (!result) {
           VAST_ERROR(self, "failed to persist partition index:",
                      self->system().render(result.error()));
@@ -219,27 +272,51 @@ behavior index(stateful_actor<index_state>* self, const path& dir,
         self->state.lookups.end(),
         [&](auto& x) { return x.second.sink == msg.source; });
       if (i != self->state.lookups.end()) {
-        // A lookup actor went down. We can remove all queued partitions where
-        // this actor was the only lookup.
-        auto is_only_lookup = [&](auto& x) {
-          return x.lookups.size() == 1 && x.lookups.count(i->first) > 0;
-        };
-        auto j = std::remove_if(self->state.scheduled.begin(),
-                                self->state.scheduled.end(), is_only_lookup);
-        auto n = self->state.scheduled.end() - j;
-        VAST_DEBUG(self, "erases", n, "scheduled lookups");
-        self->state.scheduled.erase(j, self->state.scheduled.end());
+        // A lookup actor went down.
+        cancel(self, i->first);
       } else {
         // A partition went down.
         unschedule(self, actor_cast<actor>(msg.source));
       }
     }
   );
+  // Partitions come ordered from oldest to most recent. We schedule from the
+  // back of the list, so we reverse it when asked for the oldest results
+  // first.
+  auto lookup = [=](expression const& expr, query_options opts,
+                    std::string group) -> result<uuid, size_t, size_t> {
+    auto sender = actor_cast<actor>(self->current_sender());
+    VAST_DEBUG(self, "got lookup:", expr);
+    // Identify the relevant partitions.
+    auto id = uuid::random();
+    auto partitions = self->state.part_index.lookup(expr);
+    if (partitions.empty()) {
+      VAST_DEBUG(self, "returns without result: no partitions qualify");
+      return {id, 0, 0};
+    }
+    if (has_oldest_first_option(opts))
+      std::reverse(partitions.begin(), partitions.end());
+    // Construct a new lookup context.
+    VAST_DEBUG(self, "creates new lookup context", id);
+    auto ctx = self->state.lookups.insert(
+      {id, {expr, std::move(group), sender, {}}});
+    self->monitor(sender);
+    VAST_ASSERT(ctx.second);
+    // TODO: make initial value configurable.
+    auto num_partitions = partitions.size();
+    auto n = std::min(partitions.size(), taste_parts);
+    // Start processing to deliver a taste of the result.
+    VAST_DEBUG(self, "schedules first", n, "partition(s)");
+    for (auto i = partitions.rbegin(); i != partitions.rbegin() + n; ++i)
+      schedule(self, *i, id);
+    partitions.resize(partitions.size() - n);
+    ctx.first->second.partitions = std::move(partitions);
+    return {id, num_partitions, n};
+  };
   return {
-    [=](const std::vector<event>& events) {
+    [=](const event_slice& events) {
       VAST_DEBUG(self, "got", events.size(), "events ["
-                 << events.front().id() << ',' << (events.back().id() + 1)
-                 << ')');
+                 << events.first_id() << ',' << events.last_id() << ')');
       auto partition_full = self->state.active.events > 0
         && self->state.active.events + events.size() > max_events;
       if (partition_full || !self->state.active.partition) {
@@ -262,48 +339,32 @@ behavior index(stateful_actor<index_state>* self, const path& dir,
       }
       self->state.active.events += events.size();
       self->state.part_index.add(events, self->state.active.id);
+      // The partition acknowledges the batch once indexed.
       auto msg = self->current_mailbox_element()->move_content_to_message();
-      self->send(self->state.active.partition, msg);
+      self->delegate(self->state.active.partition, std::move(msg));
     },
-    [=](expression const& expr) -> result<uuid, size_t, size_t> {
-      auto sender = actor_cast<actor>(self->current_sender());
-      VAST_DEBUG(self, "got lookup:", expr);
-      // Identify the relevant partitions.
-      auto id = uuid::random();
-      auto partitions = self->state.part_index.lookup(expr);
-      if (partitions.empty()) {
-        VAST_DEBUG(self, "returns without result: no partitions qualify");
-        return {id, 0, 0};
-      }
-      // Construct a new lookup context.
-      VAST_DEBUG(self, "creates new lookup context", id);
-      auto ctx = self->state.lookups.insert({id, {expr, sender, {}}});
-      self->monitor(sender);
-      VAST_ASSERT(ctx.second);
-      // TODO: make initial value configurable and figure out a more meaningful
-      // way to select the first N partitions, e.g., based on accumulated
-      // summary statics.
-      auto num_partitions = partitions.size();
-      auto n = std::min(partitions.size(), taste_parts);
-      // Start processing to deliver a taste of the result.
-      VAST_DEBUG(self, "schedules first", n, "partition(s)");
-      for (auto i = partitions.end() - n; i != partitions.end(); ++i)
-        schedule(self, *i, id);
-      partitions.resize(partitions.size() - n);
-      ctx.first->second.partitions = std::move(partitions);
-      return {id, num_partitions, n};
+    [=](expression const& expr) {
+      return lookup(expr, no_query_options, {});
+    },
+    [=](expression const& expr, query_options opts) {
+      return lookup(expr, opts, {});
+    },
+    [=](expression const& expr, query_options opts, group_atom,
+        std::string& group) {
+      return lookup(expr, opts, std::move(group));
     },
     [=](uuid const& id, size_t n) {
       auto& ctx = self->state.lookups[id];
       VAST_DEBUG(self, "processes lookup", id << ':', ctx.expr);
       if (n == 0) {
         VAST_DEBUG(self, "cancels lookup");
-        self->state.lookups.erase(id);
+        cancel(self, id);
         return;
       }
       n = std::min(ctx.partitions.size(), n);
       VAST_DEBUG(self, "schedules", n, "more partitions");
-      for (auto i = ctx.partitions.end() - n; i != ctx.partitions.end(); ++i)
+      for (auto i = ctx.partitions.rbegin(); i != ctx.partitions.rbegin() + n;
+           ++i)
         schedule(self, *i, id);
       ctx.partitions.resize(ctx.partitions.size() - n);
     },
@@ -8,6 +8,7 @@
 #include "vast/concept/printable/vast/key.hpp"
 #include "vast/detail/assert.hpp"
 #include "vast/event.hpp"
+#include "vast/event_slice.hpp"
 #include "vast/expression.hpp"
 #include "vast/expression_visitors.hpp"
 #include "vast/filesystem.hpp"
@@ -59,7 +60,7 @@ behavior value_indexer(stateful_actor<value_indexer_state>* self,
       self->quit(make_error(ec::unspecified, "failed to construct index"));
   }
   return {
-    [=](std::vector<event> const& events) {
+    [=](event_slice const& events) -> result<ok_atom> {
       VAST_TRACE(self, "got", events.size(), "events");
       for (auto& e : events) {
         VAST_ASSERT(e.id() != invalid_event_id);
@@ -68,10 +69,11 @@ behavior value_indexer(stateful_actor<value_indexer_state>* self,
           if (!result) {
             VAST_ERROR(self->system().render(result.error()));
             self->quit(result.error());
-            break;
+            return result.error();
           }
         }
       }
+      return ok_atom::value;
     },
     [=](predicate const& pred) -> result<bitmap> {
       VAST_TRACE(self, "got predicate:", pred);
@@ -314,10 +316,29 @@ behavior event_indexer(stateful_actor<event_indexer_state>* self,
     [=](down_msg const& msg) { remove_indexer(msg.source); }
   );
   return {
-    [=](std::vector<event> const&) {
+    [=](event_slice const&) {
+      // Acknowledge the batch once all indexers have processed it, so that
+      // the sender can throttle itself.
+      auto rp = self->make_response_promise<ok_atom>();
+      if (self->state.indexers.empty()) {
+        rp.deliver(ok_atom::value);
+        return;
+      }
+      auto n = std::make_shared<size_t>(self->state.indexers.size());
       auto msg = self->current_mailbox_element()->move_content_to_message();
       for (auto& x : self->state.indexers)
-        self->send(x.second, msg);
+        self->request(x.second, infinite, msg).then(
+          [=](ok_atom) mutable {
+            if (*n > 0 && --*n == 0)
+              rp.deliver(ok_atom::value);
+          },
+          [=](error& e) mutable {
+            if (*n > 0) {
+              *n = 0;
+              rp.deliver(std::move(e));
+            }
+          }
+        );
     },
     [=](predicate const& pred) {
       VAST_DEBUG(self, "got predicate:", pred);
@@ -99,6 +99,7 @@ void spawn(node_ptr self, message args) {
     {"archive", bind(spawn_archive)},
     {"index", bind(spawn_index)},
     {"importer", bind(spawn_importer)},
+    {"matcher", bind(spawn_matcher)},
     {"exporter", bind(spawn_exporter)},
     {"source", bind(spawn_source)},
     {"sink", bind(spawn_sink)},
@@ -140,7 +141,7 @@ void spawn(node_ptr self, message args) {
       VAST_ASSERT(reg.components.count(self->state.name) > 0);
       auto& local = reg.components[self->state.name];
       // Check if we can spawn more than one instance of the given component.
-      for (auto c : {"metastore", "archive", "index", "profiler"})
+      for (auto c : {"metastore", "archive", "index", "matcher", "profiler"})
         if (c == component && local.count(component) > 0) {
           rp.deliver(make_error(ec::unspecified, "component already exists"));
           return;
@@ -3,6 +3,7 @@
 #include "vast/bitmap.hpp"
 #include "vast/concept/parseable/numeric/integral.hpp"
 #include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/key.hpp"
 #include "vast/concept/printable/stream.hpp"
 #include "vast/concept/printable/std/chrono.hpp"
 #include "vast/concept/printable/vast/error.hpp"
@@ -10,7 +11,9 @@
 #include "vast/concept/printable/vast/filesystem.hpp"
 #include "vast/concept/printable/vast/event.hpp"
 #include "vast/detail/assert.hpp"
+#include "vast/error.hpp"
 #include "vast/event.hpp"
+#include "vast/event_slice.hpp"
 #include "vast/expression.hpp"
 #include "vast/expression_visitors.hpp"
 #include "vast/load.hpp"
@@ -170,23 +173,37 @@ behavior partition(stateful_actor<partition_state>* self, path dir) {
       self->state.indexers.emplace(x.second, actor{});
   }
   return {
-    [=](std::vector<event> const& events) {
+    [=](event_slice const& events) {
       VAST_ASSERT(!events.empty());
       VAST_DEBUG(self, "got", events.size(), "events");
       // Locate relevant indexers.
       vast::detail::flat_set<actor> indexers;
-      for (auto& e : events) {
-        auto& i = self->state.indexers[e.type()];
+      for (auto& t : events.types()) {
+        auto& i = self->state.indexers[t];
         if (!i) {
-          VAST_DEBUG(self, "creates event-indexer for type", e.type());
-          i = self->spawn(event_indexer, dir / to_digest(e.type()), e.type());
+          VAST_DEBUG(self, "creates event-indexer for type", t);
+          i = self->spawn(event_indexer, dir / to_digest(t), t);
         }
         indexers.insert(i);
       }
-      // Forward events to relevant indexers.
+      // Forward events to relevant indexers and acknowledge the batch after
+      // all of them have processed it.
+      auto rp = self->make_response_promise<ok_atom>();
+      auto n = std::make_shared<size_t>(indexers.size());
       auto msg = self->current_mailbox_element()->move_content_to_message();
       for (auto& indexer : indexers)
-        self->send(indexer, msg);
+        self->request(indexer, infinite, msg).then(
+          [=](ok_atom) mutable {
+            if (*n > 0 && --*n == 0)
+              rp.deliver(ok_atom::value);
+          },
+          [=](error& e) mutable {
+            if (*n > 0) {
+              *n = 0;
+              rp.deliver(std::move(e));
+            }
+          }
+        );
     },
     [=](expression const& expr) {
       VAST_DEBUG(self, "got expression:", expr);
@@ -249,6 +266,67 @@ behavior partition(stateful_actor<partition_state>* self, path dir) {
           send_as(coll, x, pred);
       }
     },
+    [=](expression const& expr, group_atom, std::string const& key) {
+      VAST_DEBUG(self, "got expression to group by", key << ':', expr);
+      auto rp = self->make_response_promise<group_counts>();
+      // Derive one expression per group and answer each of them from the
+      // indexes, just like a regular expression.
+      std::map<std::string, expression> groups;
+      if (key == "&type") {
+        for (auto& x : self->state.indexers) {
+          auto& name = x.first.name();
+          auto pred = predicate{attribute_extractor{"type"}, equal, data{name}};
+          groups.emplace(name, conjunction{expr, std::move(pred)});
+        }
+      } else {
+        auto k = to<vast::key>(key);
+        if (!k) {
+          rp.deliver(make_error(ec::syntax_error, "invalid group key", key));
+          return;
+        }
+        // We only know the domain of boolean fields up front.
+        for (auto& x : self->state.indexers) {
+          auto r = get_if<record_type>(x.first);
+          if (!r)
+            continue;
+          for (auto& field : r->find_suffix(*k))
+            if (!is<boolean_type>(*r->at(field.first))) {
+              rp.deliver(make_error(ec::type_clash,
+                                    "cannot group by non-boolean field", key));
+              return;
+            }
+        }
+        for (auto b : {true, false}) {
+          auto pred = predicate{key_extractor{*k}, equal, data{b}};
+          groups.emplace(b ? "T" : "F", conjunction{expr, std::move(pred)});
+        }
+      }
+      if (groups.empty()) {
+        rp.deliver(group_counts{});
+        return;
+      }
+      auto counts = std::make_shared<group_counts>();
+      auto n = std::make_shared<size_t>(groups.size());
+      for (auto& x : groups) {
+        auto label = x.first;
+        self->request(self, infinite, std::move(x.second)).then(
+          [=](const bitmap& hits) mutable {
+            if (*n == 0)
+              return;
+            if (auto count = rank(hits))
+              (*counts)[label] = count;
+            if (--*n == 0)
+              rp.deliver(std::move(*counts));
+          },
+          [=](error& e) mutable {
+            if (*n > 0) {
+              *n = 0;
+              rp.deliver(std::move(e));
+            }
+          }
+        );
+      }
+    },
     [=](shutdown_atom) {
       for (auto i = self->state.indexers.begin();
            i != self->state.indexers.end(); )
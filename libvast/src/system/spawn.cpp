@@ -4,12 +4,14 @@
 
 #include "vast/concept/parseable/to.hpp"
 #include "vast/concept/parseable/vast/expression.hpp"
+#include "vast/concept/parseable/vast/key.hpp"
 #include "vast/concept/printable/vast/expression.hpp"
 #include "vast/data.hpp"
 #include "vast/expression.hpp"
 #include "vast/expression_visitors.hpp"
 #include "vast/error.hpp"
 #include "vast/query_options.hpp"
+#include "vast/detail/string.hpp"
 
 #include "vast/system/atoms.hpp"
 #include "vast/system/archive.hpp"
@@ -19,6 +21,7 @@
 #include "vast/system/profiler.hpp"
 #include "vast/system/spawn.hpp"
 #include "vast/system/replicated_store.hpp"
+#include "vast/system/stream_matcher.hpp"
 
 using namespace std::chrono_literals;
 using namespace caf;
@@ -43,11 +46,17 @@ expected<actor> spawn_archive(local_actor* self, options& opts) {
 
 expected<actor> spawn_exporter(local_actor* self, options& opts) {
   auto limit = uint64_t{0};
+  auto group = std::string{};
+  auto project = std::string{};
   auto r = opts.params.extract_opts({
     {"continuous,c", "marks a query as continuous"},
     {"historical,h", "marks a query as historical"},
     {"unified,u", "marks a query as unified"},
+    {"oldest-first,o", "delivers the oldest results first"},
     {"limit,l", "limit the number of results", limit},
+    {"count", "count the results instead of extracting them"},
+    {"group-by", "count the results per &type or boolean field", group},
+    {"project", "export only the given comma-separated fields", project},
   }, nullptr, true);
   if (!r.error.empty())
     return make_error(ec::syntax_error, r.error);
@@ -74,9 +83,33 @@ expected<actor> spawn_exporter(local_actor* self, options& opts) {
   // Default to historical if no options provided.
   if (query_opts == no_query_options)
     query_opts = historical;
+  if (r.opts.count("oldest-first") > 0)
+    query_opts = query_opts + oldest_first;
+  // Parse aggregation options.
+  auto aggregate = r.opts.count("count") > 0 || r.opts.count("group-by") > 0;
+  if (aggregate && has_continuous_option(query_opts))
+    return make_error(ec::syntax_error, "cannot count continuous results");
+  if (!group.empty() && group != "&type" && !to<key>(group))
+    return make_error(ec::syntax_error, "invalid group key", group);
+  // Parse projection.
+  std::vector<std::string> fields;
+  if (!project.empty()) {
+    if (aggregate)
+      return make_error(ec::syntax_error, "cannot project counted results");
+    fields = detail::to_strings(detail::split(project, ","));
+    for (auto& field : fields)
+      if (!to<key>(field))
+        return make_error(ec::syntax_error, "invalid projection key", field);
+  }
   auto exp = self->spawn(exporter, std::move(*expr), query_opts);
+  if (!fields.empty())
+    anon_send(exp, project_atom::value, std::move(fields));
+  if (!group.empty())
+    anon_send(exp, count_atom::value, std::move(group));
+  else if (aggregate)
+    anon_send(exp, count_atom::value);
   if (limit > 0)
-    anon_send(exp, extract_atom::value, limit);
+    anon_send(exp, limit_atom::value, limit);
   else
     anon_send(exp, extract_atom::value);
   return exp;
@@ -109,6 +142,10 @@ expected<actor> spawn_index(local_actor* self, options& opts) {
                      taste_parts);
 }
 
+expected<actor> spawn_matcher(local_actor* self, options&) {
+  return self->spawn(stream_matcher);
+}
+
 expected<actor> spawn_metastore(local_actor* self, options& opts) {
   auto id = raft::server_id{0};
   auto r = opts.params.extract_opts({
@@ -5,6 +5,7 @@
 #include "vast/config.hpp"
 
 #include "vast/format/ascii.hpp"
+#include "vast/format/binary.hpp"
 #include "vast/format/bro.hpp"
 #include "vast/format/csv.hpp"
 #include "vast/format/json.hpp"
@@ -31,10 +32,12 @@ expected<actor> spawn_sink(local_actor* self, options& opts) {
   // Parse common parameters first.
   auto output = "-"s;
   auto schema_file = ""s;
+  auto workers = size_t{1};
   auto r = sink_args.extract_opts({
     {"write,w", "path to write events to", output},
     //{"schema,s", "alternate schema file", schema_file},
-    {"uds,d", "treat -w as UNIX domain socket to connect to"}
+    {"uds,d", "treat -w as UNIX domain socket to connect to"},
+    {"workers,j", "threads rendering events (0 = all cores)", workers}
   }, nullptr, true);
   auto grd = caf::detail::make_scope_guard([&] { opts.params = r.remainder; });
   actor snk;
@@ -53,20 +56,23 @@ expected<actor> spawn_sink(local_actor* self, options& opts) {
     snk = self->spawn(sink<format::pcap::writer>, std::move(writer));
 #endif
   } else if (format == "bro") {
-    format::bro::writer writer{output};
+    format::bro::writer writer{output, workers};
     snk = self->spawn(sink<format::bro::writer>, std::move(writer));
   } else {
     auto out = detail::make_output_stream(output, r.opts.count("uds") > 0);
     if (!out)
       return out.error();
     if (format == "csv") {
-      format::csv::writer writer{std::move(*out)};
+      format::csv::writer writer{std::move(*out), workers};
       snk = self->spawn(sink<format::csv::writer>, std::move(writer));
     } else if (format == "ascii") {
-      format::ascii::writer writer{std::move(*out)};
+      format::ascii::writer writer{std::move(*out), workers};
       snk = self->spawn(sink<format::ascii::writer>, std::move(writer));
+    } else if (format == "binary") {
+      format::binary::writer writer{std::move(*out)};
+      snk = self->spawn(sink<format::binary::writer>, std::move(writer));
     } else if (format == "json") {
-      format::json::writer writer{std::move(*out)};
+      format::json::writer writer{std::move(*out), workers};
       snk = self->spawn(sink<format::json::writer>, std::move(writer));
     } else {
       return make_error(ec::syntax_error, "invalid format:", format);
@@ -12,6 +12,7 @@
 #include "vast/query_options.hpp"
 
 #include "vast/format/bgpdump.hpp"
+#include "vast/format/binary.hpp"
 #include "vast/format/bro.hpp"
 #ifdef VAST_HAVE_PCAP
 #include "vast/format/pcap.hpp"
@@ -38,10 +39,12 @@ expected<actor> spawn_source(local_actor* self, options& opts) {
   // Parse format-independent parameters first.
   auto input = "-"s;
   std::string schema_file;
+  auto in_flight = uint64_t{4};
   auto r = source_args.extract_opts({
     {"read,r", "path to input where to read events from", input},
     {"schema,s", "path to alternate schema", schema_file},
-    {"uds,d", "treat -r as listening UNIX domain socket"}
+    {"uds,d", "treat -r as listening UNIX domain socket"},
+    {"in-flight,b", "max number of unacknowledged batches", in_flight}
   });
   // Ensure that, upon leaving this function, we have updated the parameter
   // list such that it no longer contains the command line options that we have
@@ -58,27 +61,32 @@ expected<actor> spawn_source(local_actor* self, options& opts) {
     auto flow_expiry = 10u;
     auto cutoff = std::numeric_limits<size_t>::max();
     auto pseudo_realtime = int64_t{0};
+    auto shards = size_t{1};
     r = r.remainder.extract_opts({
       {"cutoff,c", "skip flow packets after this many bytes", cutoff},
       {"flow-max,m", "number of concurrent flows to track", flow_max},
       {"flow-age,a", "max flow lifetime before eviction", flow_age},
       {"flow-expiry,e", "flow table expiration interval", flow_expiry},
       {"pseudo-realtime,p", "factor c delaying trace packets by 1/c",
-       pseudo_realtime}
+       pseudo_realtime},
+      {"shards,n", "number of threads processing flows", shards}
     });
     if (!r.error.empty())
       return make_error(ec::syntax_error, r.error);
     format::pcap::reader reader{input, cutoff, flow_max, flow_age, flow_expiry,
-                                pseudo_realtime};
+                                pseudo_realtime, shards};
     src = self->spawn(source<format::pcap::reader>, std::move(reader));
 #endif
-  } else if (format == "bro" || format == "bgpdump") {
+  } else if (format == "bro" || format == "bgpdump" || format == "binary") {
     auto in = detail::make_input_stream(input, r.opts.count("uds") > 0);
     if (!in)
       return in.error();
     if (format == "bro") {
       format::bro::reader reader{std::move(*in)};
       src = self->spawn(source<format::bro::reader>, std::move(reader));
+    } else if (format == "binary") {
+      format::binary::reader reader{std::move(*in)};
+      src = self->spawn(source<format::binary::reader>, std::move(reader));
     } else /* if (format == "bgpdump") */ {
       format::bgpdump::reader reader{std::move(*in)};
       src = self->spawn(source<format::bgpdump::reader>, std::move(reader));
@@ -102,6 +110,8 @@ expected<actor> spawn_source(local_actor* self, options& opts) {
   } else {
     return make_error(ec::syntax_error, "invalid format:", format);
   }
+  // Bound the number of batches the source ships without acknowledgement.
+  anon_send(src, credit_atom::value, in_flight);
   // Supply an alternate schema, if requested.
   if (!schema_file.empty()) {
     auto str = load_contents(schema_file);
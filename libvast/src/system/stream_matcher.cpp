@@ -0,0 +1,82 @@
+#include <caf/all.hpp>
+
+#include "vast/error.hpp"
+#include "vast/event_slice.hpp"
+#include "vast/expression.hpp"
+#include "vast/logger.hpp"
+#include "vast/concept/printable/vast/expression.hpp"
+#include "vast/detail/assert.hpp"
+
+#include "vast/system/atoms.hpp"
+#include "vast/system/stream_matcher.hpp"
+
+using namespace caf;
+
+namespace vast {
+namespace system {
+
+namespace {
+
+void unsubscribe(stateful_actor<stream_matcher_state>* self,
+                 actor_addr const& subscriber) {
+  auto& subscribers = self->state.subscribers;
+  for (auto i = subscribers.begin(); i != subscribers.end(); ) {
+    if (i->second.address() == subscriber) {
+      VAST_DEBUG(self, "removes standing query", i->first);
+      self->state.matcher.remove(i->first);
+      i = subscribers.erase(i);
+    } else {
+      ++i;
+    }
+  }
+}
+
+} // namespace <anonymous>
+
+behavior stream_matcher(stateful_actor<stream_matcher_state>* self) {
+  self->set_down_handler(
+    [=](down_msg const& msg) {
+      unsubscribe(self, msg.source);
+    }
+  );
+  return {
+    [=](subscribe_atom, expression& expr) -> result<ok_atom> {
+      auto subscriber = actor_cast<actor>(self->current_sender());
+      if (!subscriber)
+        return make_error(ec::unspecified, "anonymous subscription");
+      auto id = self->state.next_id++;
+      VAST_DEBUG(self, "adds standing query", id << ':', expr);
+      self->state.matcher.add(id, std::move(expr));
+      self->state.subscribers.emplace(id, subscriber);
+      self->monitor(subscriber);
+      return ok_atom::value;
+    },
+    [=](delete_atom) {
+      unsubscribe(self, actor_cast<actor_addr>(self->current_sender()));
+    },
+    [=](event_slice const& slice) {
+      if (self->state.matcher.empty())
+        return;
+      // Collect the matches of the whole slice first, so that each subscriber
+      // gets at most one message per slice.
+      std::unordered_map<query_matcher::query_id, std::vector<event>> matches;
+      std::vector<query_matcher::query_id> ids;
+      for (auto& e : slice) {
+        ids.clear();
+        self->state.matcher.match(e, ids);
+        for (auto id : ids)
+          matches[id].push_back(e);
+      }
+      for (auto& x : matches) {
+        VAST_DEBUG(self, "relays", x.second.size(), "matches of query",
+                   x.first);
+        auto i = self->state.subscribers.find(x.first);
+        VAST_ASSERT(i != self->state.subscribers.end());
+        self->send(i->second, continuous_atom::value, std::move(x.second));
+      }
+    }
+  };
+}
+
+} // namespace system
+} // namespace vast
@@ -64,6 +64,7 @@ tracker(tracker_type::stateful_pointer<tracker_state> self, std::string node) {
           };
           shutdown("source");
           shutdown("importer");
+          shutdown("matcher");
           shutdown("archive");
           shutdown("index");
           shutdown("exporter");
@@ -103,6 +104,8 @@ tracker(tracker_type::stateful_pointer<tracker_state> self, std::string node) {
           self->anon_send(component, index_atom::value, a);
         for (auto& a : actors("sink"))
           self->anon_send(component, sink_atom::value, a);
+        for (auto& a : actors("matcher"))
+          self->anon_send(component, matcher_atom::value, a);
       } else if (type == "importer") {
         for (auto& a : actors("metastore"))
           self->anon_send(component, actor_cast<meta_store_type>(a));
@@ -112,6 +115,13 @@ tracker(tracker_type::stateful_pointer<tracker_state> self, std::string node) {
           self->anon_send(component, index_atom::value, a);
         for (auto& a : actors("source"))
           self->anon_send(a, sink_atom::value, component);
+        for (auto& a : actors("matcher"))
+          self->anon_send(component, matcher_atom::value, a);
+      } else if (type == "matcher") {
+        for (auto& a : actors("importer"))
+          self->anon_send(a, matcher_atom::value, component);
+        for (auto& a : actors("exporter"))
+          self->anon_send(a, matcher_atom::value, component);
       } else if (type == "source") {
         for (auto& a : actors("importer"))
           self->anon_send(component, sink_atom::value, a);
@@ -64,7 +64,7 @@ std::unique_ptr<value_index> value_index::make(type const& t) {
       auto b = parse_base(t);
       if (!b)
         return nullptr;
-      return std::make_unique<arithmetic_index<timestamp>>(std::move(*b));
+      return std::make_unique<timestamp_index>(std::move(*b));
     }
     result_type operator()(string_type const& t) const {
       auto max_length = size_t{1024};
@@ -99,7 +99,7 @@ std::unique_ptr<value_index> value_index::make(type const& t) {
         else
           return nullptr;
       }
-      return std::make_unique<sequence_index>(t.value_type, max_size);
+      return std::make_unique<element_index>(t.value_type, max_size);
     }
     result_type operator()(set_type const& t) const {
       auto max_size = size_t{1024};
@@ -109,7 +109,7 @@ std::unique_ptr<value_index> value_index::make(type const& t) {
         else
           return nullptr;
       }
-      return std::make_unique<sequence_index>(t.value_type, max_size);
+      return std::make_unique<element_index>(t.value_type, max_size);
     }
     result_type operator()(table_type const&) const {
       return nullptr;
@@ -272,6 +272,94 @@ string_index::lookup_impl(relational_operator op, data const& x) const {
   }
 }
 
+timestamp_index::timestamp_index(base b)
+  : exception_index_{std::move(b)} {
+}
+
+bool timestamp_index::push_back_impl(data const& x, size_type skip) {
+  auto ts = get_if<timestamp>(x);
+  if (!ts)
+    return false;
+  auto t = ts->time_since_epoch().count();
+  auto binned = binner_type::bin(t);
+  auto id = exceptions_.size() + skip;
+  exceptions_.append_bits(false, skip);
+  if (times_.empty() || binned > times_.back()) {
+    // A new distinct timestamp in order opens a new checkpoint.
+    times_.push_back(binned);
+    ids_.push_back(id);
+    exceptions_.append_bit(false);
+  } else if (binned == times_.back()) {
+    // Falls into the range of the latest checkpoint.
+    exceptions_.append_bit(false);
+  } else {
+    exception_index_.push_back(t, id - exception_index_.size());
+    exceptions_.append_bit(true);
+  }
+  return true;
+}
+
+expected<bitmap>
+timestamp_index::lookup_impl(relational_operator op, data const& x) const {
+  auto ts = get_if<timestamp>(x);
+  if (!ts)
+    return make_error(ec::type_clash, x);
+  auto t = ts->time_since_epoch().count();
+  auto binned = binner_type::bin(t);
+  auto lower = [&] {
+    auto i = std::lower_bound(times_.begin(), times_.end(), binned);
+    return first_id(i - times_.begin());
+  };
+  auto upper = [&] {
+    auto i = std::upper_bound(times_.begin(), times_.end(), binned);
+    return first_id(i - times_.begin());
+  };
+  auto size = exceptions_.size();
+  bitmap result;
+  switch (op) {
+    default:
+      return make_error(ec::unsupported_operator, op);
+    case less:
+      result = in_order(0, lower());
+      break;
+    case less_equal:
+      result = in_order(0, upper());
+      break;
+    case greater:
+      result = in_order(upper(), size);
+      break;
+    case greater_equal:
+      result = in_order(lower(), size);
+      break;
+    case equal:
+      result = in_order(lower(), upper());
+      break;
+    case not_equal:
+      result = in_order(0, lower()) | in_order(upper(), size);
+      break;
+  }
+  if (exception_index_.empty())
+    return result;
+  auto exceptions = exception_index_.lookup(op, t);
+  exceptions.append_bits(false, size - exceptions.size());
+  result |= exceptions & exceptions_;
+  return result;
+}
+
+bitmap timestamp_index::in_order(size_type first, size_type last) const {
+  auto size = exceptions_.size();
+  VAST_ASSERT(first <= last && last <= size);
+  bitmap result;
+  result.append_bits(false, first);
+  result.append_bits(true, last - first);
+  result.append_bits(false, size - last);
+  return result - exceptions_;
+}
+
+timestamp_index::size_type timestamp_index::first_id(size_t i) const {
+  return i < ids_.size() ? ids_[i] : exceptions_.size();
+}
+
 void address_index::init() {
   if (bytes_[0].coder().storage().empty())
     // Initialize on first to make deserialization feasible.
@@ -546,4 +634,87 @@ void serialize(caf::deserializer& source, sequence_index& idx) {
     throw std::runtime_error{to_string(e)};
 }
 
+element_index::element_index(vast::type t, size_t max_size)
+  : max_size_{max_size},
+    value_type_{std::move(t)} {
+}
+
+bool element_index::push_back_impl(data const& x, size_type skip) {
+  if (auto v = get_if<vector>(x))
+    return push_back_ctnr(*v, skip);
+  if (auto s = get_if<set>(x))
+    return push_back_ctnr(*s, skip);
+  return false;
+}
+
+expected<bitmap>
+element_index::lookup_impl(relational_operator op, data const& x) const {
+  if (op == ni)
+    op = in;
+  else if (op == not_ni)
+    op = not_in;
+  if (!(op == in || op == not_in))
+    return make_error(ec::unsupported_operator, op);
+  if (!elements_)
+    return bitmap{owners_.size(), op == not_in};
+  auto slots = elements_->lookup(equal, x);
+  if (!slots)
+    return slots;
+  // Walk the hits in slot order alongside the container boundaries and map
+  // each slot to the ID of its container.
+  bitmap result;
+  auto starts = select(starts_);
+  auto owners = select(owners_);
+  auto owner = owners.get();
+  starts.next();
+  for (auto slot : select(*slots)) {
+    while (!starts.done() && starts.get() <= slot) {
+      starts.next();
+      owners.next();
+      owner = owners.get();
+    }
+    if (owner >= result.size()) {
+      result.append_bits(false, owner - result.size());
+      result.append_bit(true);
+    }
+  }
+  result.append_bits(false, owners_.size() - result.size());
+  if (op == not_in)
+    result.flip();
+  return result;
+}
+
+void serialize(caf::serializer& sink, element_index const& idx) {
+  sink & static_cast<value_index const&>(idx);
+  sink & idx.value_type_;
+  sink & idx.max_size_;
+  sink & idx.starts_;
+  sink & idx.owners_;
+  // Polymorphic index, which exists only after the first non-empty container.
+  auto has_elements = idx.elements_ != nullptr;
+  sink & has_elements;
+  if (has_elements) {
+    auto& t = const_cast<type&>(idx.value_type_);
+    auto& x = const_cast<std::unique_ptr<value_index>&>(idx.elements_);
+    detail::value_index_inspect_helper helper{t, x};
+    sink & helper;
+  }
+}
+
+void serialize(caf::deserializer& source, element_index& idx) {
+  source & static_cast<value_index&>(idx);
+  source & idx.value_type_;
+  source & idx.max_size_;
+  source & idx.starts_;
+  source & idx.owners_;
+  auto has_elements = false;
+  source & has_elements;
+  if (has_elements) {
+    detail::value_index_inspect_helper helper{idx.value_type_, idx.elements_};
+    source & helper;
+  } else {
+    idx.elements_.reset();
+  }
+}
+
 } // namespace vast
@@ -1,6 +1,7 @@
 #include "vast/bitmap.hpp"
 #include "vast/ewah_bitmap.hpp"
 #include "vast/null_bitmap.hpp"
+#include "vast/detail/block_kernels.hpp"
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/bitmap.hpp"
 
@@ -792,3 +793,121 @@ TEST(EWAH RLE print 2) {
   //CHECK_EQUAL(str, "1F1T421F2T");
   CHECK_EQUAL(str, "1F1T62F320F39F2T");
 }
+
+TEST(EWAH bitwise NOT of full blocks) {
+  ewah_bitmap bm;
+  bm.append_bits(false, 128);
+  auto flipped = ~bm;
+  CHECK_EQUAL(flipped.size(), 128u);
+  CHECK(flipped.all());
+  CHECK(bm == ~flipped);
+}
+
+namespace {
+
+// Generates a bitmap that mixes long runs of dirty words with clean runs,
+// which makes the bitwise operations take the vectorized code paths.
+template <class Bitmap>
+Bitmap make_mixed(uint64_t seed, size_t size) {
+  Bitmap bm;
+  auto next = [&] {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    return seed >> 11;
+  };
+  while (bm.size() < size) {
+    auto n = std::min(size - bm.size(), size_t{64} * (1 + next() % 16));
+    if (next() % 3 == 0)
+      bm.append_bits(next() % 2 == 0, n);
+    else
+      for (auto i = 0u; i < n; ++i)
+        bm.append_bit(next() % 2 == 0);
+  }
+  return bm;
+}
+
+} // namespace <anonymous>
+
+TEST(bitwise operations on long dirty runs) {
+  MESSAGE("using " << detail::block_kernels_isa() << " kernels");
+  for (auto seed = 1u; seed <= 8; ++seed) {
+    auto n = 1000 + 347 * seed;
+    auto m = 1000 + 211 * (9 - seed);
+    auto ex = make_mixed<ewah_bitmap>(seed, n);
+    auto ey = make_mixed<ewah_bitmap>(seed * 42, m);
+    auto nx = make_mixed<null_bitmap>(seed, n);
+    auto ny = make_mixed<null_bitmap>(seed * 42, m);
+    REQUIRE_EQUAL(to_string(ex), to_string(nx));
+    REQUIRE_EQUAL(to_string(ey), to_string(ny));
+    CHECK_EQUAL(to_string(ex & ey), to_string(nx & ny));
+    CHECK_EQUAL(to_string(ex | ey), to_string(nx | ny));
+    CHECK_EQUAL(to_string(ex ^ ey), to_string(nx ^ ny));
+    CHECK_EQUAL(to_string(ex - ey), to_string(nx - ny));
+    CHECK_EQUAL(to_string(ey - ex), to_string(ny - nx));
+    CHECK_EQUAL(rank<1>(ex), rank<1>(nx));
+    CHECK_EQUAL(rank<0>(ey), rank<0>(ny));
+    CHECK_EQUAL(rank<1>(ex, n / 2), rank<1>(nx, n / 2));
+    CHECK_EQUAL(rank<1>(bitmap{ex & ey}), rank<1>(nx & ny));
+  }
+}
+
+TEST(chain evaluation) {
+  auto x = make_mixed<ewah_bitmap>(1, 5000);
+  auto y = make_mixed<ewah_bitmap>(2, 5000);
+  auto z = make_mixed<ewah_bitmap>(3, 5000);
+  auto ones = ewah_bitmap{5000, true};
+  bitwise_chain<ewah_bitmap> chain{
+    {bitwise_and, &y},
+    {bitwise_or, &z},
+    {minus, &x},
+    {bitwise_xor, &ones}
+  };
+  auto expected = ~(((x & y) | z) - x);
+  CHECK_EQUAL(chain_eval(x, chain), expected);
+  MESSAGE("type-erased bitmaps");
+  auto bx = bitmap{x};
+  auto by = bitmap{y};
+  auto bz = bitmap{z};
+  auto bones = bitmap{ones};
+  bitwise_chain<bitmap> bchain{
+    {bitwise_and, &by},
+    {bitwise_or, &bz},
+    {minus, &bx},
+    {bitwise_xor, &bones}
+  };
+  CHECK_EQUAL(chain_eval(bx, bchain), bitmap{expected});
+  MESSAGE("n-ary operations");
+  std::vector<ewah_bitmap> xs{x, y, z};
+  CHECK_EQUAL(nary_and(xs.begin(), xs.end()), x & y & z);
+  CHECK_EQUAL(nary_or(xs.begin(), xs.end()), x | y | z);
+}
+
+TEST(EWAH skip index) {
+  auto bm = make_mixed<ewah_bitmap>(7, 20000);
+  bm.append_bits(false, 100000);
+  bm.append_bit(true);
+  auto ref = make_mixed<null_bitmap>(7, 20000);
+  ref.append_bits(false, 100000);
+  ref.append_bit(true);
+  ewah_skip_index idx{bm, 4};
+  MESSAGE("select");
+  CHECK_EQUAL(idx.select(1), select(ref, 1));
+  CHECK_EQUAL(idx.select(-1), 120000u);
+  CHECK_EQUAL(select(bm, -1), 120000u);
+  CHECK_EQUAL(idx.select(rank(ref) + 1), ewah_bitmap::word_type::npos);
+  for (auto i : {2u, 17u, 500u, 4242u})
+    CHECK_EQUAL(idx.select(i), select(ref, i));
+  MESSAGE("rank");
+  CHECK_EQUAL(idx.rank(), rank(ref));
+  CHECK_EQUAL(idx.rank<0>(), rank<0>(ref));
+  for (auto i : {1u, 63u, 64u, 1000u, 19999u, 20000u, 119999u, 120000u})
+    CHECK_EQUAL(idx.rank(i), rank(ref, i));
+  MESSAGE("find_next");
+  CHECK_EQUAL(idx.find_next(ewah_bitmap::word_type::npos), select(ref, 1));
+  CHECK_EQUAL(idx.find_next(19999), 120000u);
+  CHECK_EQUAL(idx.find_next(120000), ewah_bitmap::word_type::npos);
+  MESSAGE("type-erased bitmap");
+  auto x = bitmap{bm};
+  bitmap_skip_index bidx{x};
+  CHECK_EQUAL(bidx.find_next(20000), 120000u);
+  CHECK_EQUAL(bidx.rank(), rank(ref));
+}
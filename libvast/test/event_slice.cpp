@@ -0,0 +1,71 @@
+#include "vast/event_slice.hpp"
+#include "vast/load.hpp"
+#include "vast/save.hpp"
+
+#define SUITE event_slice
+#include "test.hpp"
+
+using namespace vast;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    foo = count_type{};
+    foo.name("foo");
+    bar = boolean_type{};
+    bar.name("bar");
+    auto id = event_id{42};
+    auto add = [&](data x, type const& t) {
+      xs.push_back(event::make(std::move(x), t));
+      xs.back().id(id++);
+    };
+    add(count{1}, foo);
+    add(count{2}, foo);
+    add(true, bar);
+    add(count{3}, foo);
+  }
+
+  type foo;
+  type bar;
+  std::vector<event> xs;
+};
+
+} // namespace <anonymous>
+
+FIXTURE_SCOPE(event_slice_tests, fixture)
+
+TEST(event slice construction) {
+  event_slice empty;
+  CHECK(empty.empty());
+  CHECK_EQUAL(empty.size(), 0u);
+  CHECK_EQUAL(empty.first_id(), invalid_event_id);
+  CHECK(empty.types().empty());
+  event_slice slice{xs};
+  REQUIRE_EQUAL(slice.size(), 4u);
+  CHECK_EQUAL(slice.first_id(), 42u);
+  CHECK_EQUAL(slice.last_id(), 46u);
+  REQUIRE_EQUAL(slice.types().size(), 2u);
+  CHECK(slice.types()[0] == foo);
+  CHECK(slice.types()[1] == bar);
+  CHECK(std::equal(slice.begin(), slice.end(), xs.begin()));
+}
+
+TEST(event slice sharing) {
+  event_slice x{xs};
+  auto y = x;
+  CHECK_EQUAL(&x.events(), &y.events());
+}
+
+TEST(event slice serialization) {
+  event_slice x{xs};
+  std::vector<char> buf;
+  save(buf, x);
+  event_slice y;
+  load(buf, y);
+  CHECK(y.events() == x.events());
+  CHECK(y.types() == x.types());
+  CHECK_EQUAL(y.first_id(), x.first_id());
+}
+
+FIXTURE_SCOPE_END()
@@ -1,3 +1,4 @@
+#include "vast/checker.hpp"
 #include "vast/event.hpp"
 #include "vast/expression.hpp"
 #include "vast/expression_visitors.hpp"
@@ -142,4 +143,73 @@ TEST(evaluation - schema) {
   CHECK(is<none>(*ast_resolved));
 }
 
+TEST(evaluation - compiled checker) {
+  auto check = [&](std::string const& str, event const& x, type const& t) {
+    auto ast = to<expression>(str);
+    REQUIRE(ast);
+    auto expr = normalize(*ast);
+    auto tailored = tailor(expr, t);
+    REQUIRE(tailored);
+    auto c = make_checker(expr, t);
+    REQUIRE(c);
+    CHECK(*c);
+    CHECK(*tailored == c->expr());
+    auto result = (*c)(x);
+    // The compiled checker must agree with the AST walk.
+    CHECK_EQUAL(result, visit(event_evaluator{x}, *tailored));
+    std::vector<uint8_t> batch;
+    (*c)(&x, 1, batch);
+    REQUIRE_EQUAL(batch.size(), 1u);
+    CHECK_EQUAL(batch[0] != 0, result);
+    return result;
+  };
+  CHECK(check("&type == \"foo\"", e0, *foo));
+  CHECK(!check("&type == \"foo\"", e1, *bar));
+  CHECK(check("&time < 2014-01-16+05:30:12", e0, *foo));
+  CHECK(check(":count == 42", e0, *foo));
+  CHECK(!check(":count != 42", e0, *foo));
+  CHECK(check(":int != +101 && :real >= -4.8", e0, *foo));
+  CHECK(check(":string ~ /bar/ && :int == +100", e0, *foo));
+  CHECK(check("s1 ni \"bb\" && c in {41, 42}", e0, *foo));
+  CHECK(!check("s1 !ni \"bb\"", e0, *foo));
+  CHECK(check("c > 41 && c <= 42 && ! c == 41", e0, *foo));
+  CHECK(check("s1 == \"babba\" || d1 > 2.0", e0, *foo));
+  CHECK(!check("s1 == \"yadda\" || d1 > 2.0", e0, *foo));
+  CHECK(check("r.b == F && r.s in /a/", e1, *bar));
+  CHECK(!check("r.s ~ /a/", e1, *bar));
+  CHECK(!check(":count == 42", e1, *bar));
+  MESSAGE("default-constructed checker");
+  checker c;
+  CHECK(!c);
+  CHECK(!c(e0));
+}
+
+TEST(evaluation - batch checker) {
+  std::vector<event> xs;
+  for (auto i = 0; i < 100; ++i)
+    xs.push_back(event::make(vector{i % 2 ? "babba" : "yadda", i * 0.5,
+                                    count(i), integer{i - 50}, "bar", nil},
+                             *foo));
+  auto exprs = {
+    "c >= 10 && c < 20",
+    "i == -3 || d1 > 42.0",
+    "! s1 == \"yadda\" && c != 5",
+    "d2 == 1.0 || s1 in /bb/",
+    "s1 < \"c\" && s2 != \"baz\"",
+    ":count in {3, 4, 5} || s1 ni \"dd\"",
+  };
+  for (auto str : exprs) {
+    auto ast = to<expression>(str);
+    REQUIRE(ast);
+    auto c = make_checker(normalize(*ast), *foo);
+    REQUIRE(c);
+    std::vector<uint8_t> selected{42};
+    (*c)(xs.data(), xs.size(), selected);
+    REQUIRE_EQUAL(selected.size(), xs.size() + 1);
+    CHECK_EQUAL(selected[0], 42u);
+    for (auto i = 0u; i < xs.size(); ++i)
+      CHECK_EQUAL(selected[i + 1] != 0, (*c)(xs[i]));
+  }
+}
+
 FIXTURE_SCOPE_END()
@@ -1,3 +1,5 @@
+#include <fstream>
+
 #include "vast/concept/parseable/to.hpp"
 #include "vast/event.hpp"
 
@@ -72,4 +74,62 @@ TEST(bro writer) {
   CHECK(exists(dir / bro_http_log[0].type().name() + ".log"));
 }
 
+TEST(bro writer parallel rendering) {
+  auto xs = bro_conn_log;
+  xs.insert(xs.end(), bro_http_log.begin(), bro_http_log.end());
+  xs.insert(xs.end(), bro_conn_log.begin(), bro_conn_log.end());
+  // Returns the log lines of a type, without the header and footer.
+  auto lines = [](path const& filename) {
+    std::ifstream in{filename.str()};
+    std::vector<std::string> result;
+    std::string line;
+    while (std::getline(in, line))
+      if (!line.empty() && line[0] != '#')
+        result.push_back(std::move(line));
+    return result;
+  };
+  auto dir = path{"vast-unit-test-bro-parallel"};
+  auto guard = caf::detail::make_scope_guard([&] { rm(dir); });
+  for (auto workers : {size_t{1}, size_t{4}}) {
+    format::bro::writer writer{dir / std::to_string(workers), workers};
+    REQUIRE(writer.write(xs));
+  }
+  for (auto name : {"bro::conn.log", "bro::http.log"}) {
+    auto sequential = lines(dir / "1" / name);
+    auto parallel = lines(dir / "4" / name);
+    CHECK(!sequential.empty());
+    CHECK(sequential == parallel);
+  }
+  CHECK_EQUAL(lines(dir / "1" / "bro::conn.log").size(),
+              2 * bro_conn_log.size());
+}
+
+TEST(bro reader parallel parsing) {
+  auto read = [](size_t workers) {
+    auto input = std::make_unique<std::ifstream>(bro::conn);
+    format::bro::reader reader{std::move(input), workers};
+    return extract(reader);
+  };
+  auto xs = read(1);
+  auto ys = read(4);
+  REQUIRE_EQUAL(xs.size(), ys.size());
+  CHECK_EQUAL(xs.size(), bro_conn_log.size());
+  auto same_data = [](event const& x, event const& y) {
+    return x.type() == y.type() && x.data() == y.data();
+  };
+  CHECK(std::equal(xs.begin(), xs.end(), ys.begin(), same_data));
+}
+
+TEST(bro reader batch interface) {
+  auto input = std::make_unique<std::ifstream>(bro::conn);
+  format::bro::reader reader{std::move(input)};
+  std::vector<event> xs;
+  auto r = expected<void>{no_error};
+  while (r)
+    r = reader.read(xs, 1000);
+  CHECK(r.error() == ec::end_of_input);
+  REQUIRE_EQUAL(xs.size(), bro_conn_log.size());
+  CHECK_EQUAL(xs.back().data(), bro_conn_log.back().data());
+}
+
 FIXTURE_SCOPE_END()
@@ -1,8 +1,13 @@
+#include <algorithm>
+#include <limits>
+
 #include "vast/error.hpp"
 #include "vast/event.hpp"
 
 #include "vast/concept/parseable/to.hpp"
 #include "vast/concept/parseable/vast/address.hpp"
+#include "vast/concept/printable/stream.hpp"
+#include "vast/concept/printable/vast/data.hpp"
 #include "vast/filesystem.hpp"
 
 #include "vast/format/pcap.hpp"
@@ -68,3 +73,74 @@ TEST(PCAP read/write 2) {
     if (!writer.write(e))
       FAIL("failed to write event");
 }
+
+TEST(PCAP flow table) {
+  format::pcap::flow_table flows{3, 10};
+  auto conn = [](count i) {
+    format::pcap::connection c;
+    c.src = *to<address>("10.0.0.1");
+    c.dst = *to<address>("10.0.0.2");
+    c.sport = {static_cast<port::number_type>(i), port::tcp};
+    c.dport = {80, port::tcp};
+    return c;
+  };
+  flows.lookup(conn(1), 100).bytes = 42;
+  flows.lookup(conn(2), 100);
+  CHECK_EQUAL(flows.size(), 2u);
+  CHECK_EQUAL(flows.lookup(conn(1), 105).bytes, 42u);
+  MESSAGE("evict inactive flows");
+  CHECK_EQUAL(flows.expire(110), 0u);
+  CHECK_EQUAL(flows.expire(111), 1u);
+  CHECK_EQUAL(flows.size(), 1u);
+  CHECK_EQUAL(flows.lookup(conn(1), 111).bytes, 42u);
+  CHECK_EQUAL(flows.lookup(conn(2), 111).bytes, 0u);
+  MESSAGE("evict random flows when full");
+  flows.lookup(conn(3), 111);
+  flows.lookup(conn(4), 111);
+  CHECK_EQUAL(flows.size(), 3u);
+}
+
+TEST(PCAP sharded read) {
+  // Without flow eviction, sharding must not change which packets survive
+  // the cutoff, only the order in which they arrive.
+  auto read_all = [](size_t shards) {
+    format::pcap::reader reader{traces::workshop_2011_browse, 64, 100000,
+                                3600, 3600, 0, shards};
+    std::vector<event> xs;
+    auto r = reader.read(xs, 1000);
+    while (r)
+      r = reader.read(xs, 1000);
+    CHECK(r.error() == ec::end_of_input);
+    return xs;
+  };
+  auto xs = read_all(1);
+  auto ys = read_all(4);
+  REQUIRE(!xs.empty());
+  REQUIRE_EQUAL(xs.size(), ys.size());
+  auto by_time = [](event const& x, event const& y) {
+    if (x.timestamp() != y.timestamp())
+      return x.timestamp() < y.timestamp();
+    return x.data() < y.data();
+  };
+  std::sort(xs.begin(), xs.end(), by_time);
+  std::sort(ys.begin(), ys.end(), by_time);
+  for (auto i = 0u; i < xs.size(); ++i)
+    CHECK_EQUAL(xs[i].data(), ys[i].data());
+}
+
+TEST(PCAP capture timeout) {
+  // An unbounded batch on an idle interface can only end when the capture
+  // times out. Capturing requires privileges, so we skip the test if the
+  // loopback interface cannot be opened.
+  for (auto shards : {size_t{1}, size_t{2}}) {
+    format::pcap::reader reader{"lo", uint64_t(-1), 100000, 60, 10, 0,
+                                shards};
+    std::vector<event> xs;
+    auto r = reader.read(xs, std::numeric_limits<size_t>::max());
+    if (!r && r.error() == ec::format_error) {
+      MESSAGE("cannot capture on loopback, skipping");
+      return;
+    }
+    CHECK(r);
+  }
+}
@@ -1,6 +1,11 @@
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
 #include "vast/detail/string.hpp"
 
 #include "vast/format/ascii.hpp"
+#include "vast/format/binary.hpp"
 #include "vast/format/csv.hpp"
 #include "vast/format/json.hpp"
 
@@ -41,6 +46,18 @@ std::vector<std::string> generate(std::vector<event> const& xs) {
   return lines;
 }
 
+template <class Writer>
+std::string render(std::vector<event> const& xs, size_t workers) {
+  std::string str;
+  auto sb = new caf::containerbuf<std::string>{str};
+  auto out = std::make_unique<std::ostream>(sb);
+  Writer writer{std::move(out), workers};
+  if (!writer.write(xs))
+    FAIL("failed to write events");
+  writer.flush();
+  return str;
+}
+
 } // namespace <anonymous>
 
 TEST(Bro writer) {
@@ -65,4 +82,53 @@ TEST(JSON writer) {
   CHECK_EQUAL(lines.front(), first_json_bgpdump_txt_line);
 }
 
+TEST(parallel writers) {
+  auto xs = bro_http_log;
+  xs.insert(xs.end(), bgpdump_txt.begin(), bgpdump_txt.end());
+  xs.insert(xs.end(), bro_http_log.begin(), bro_http_log.end());
+  MESSAGE("CSV headers stay in place");
+  auto csv = render<format::csv::writer>(xs, 1);
+  CHECK_EQUAL(render<format::csv::writer>(xs, 4), csv);
+  MESSAGE("JSON");
+  auto json = render<format::json::writer>(xs, 1);
+  CHECK_EQUAL(render<format::json::writer>(xs, 4), json);
+}
+
+TEST(binary writer and reader) {
+  std::string str;
+  auto sb = new caf::containerbuf<std::string>{str};
+  auto out = std::make_unique<std::ostream>(sb);
+  MESSAGE("writing events in small frames");
+  {
+    format::binary::writer writer{std::move(out), 4096};
+    for (auto& e : bro_http_log)
+      REQUIRE(writer.write(e));
+    for (auto& e : bgpdump_txt)
+      REQUIRE(writer.write(e));
+  }
+  REQUIRE(!str.empty());
+  MESSAGE("reading events back");
+  auto in = std::make_unique<std::istringstream>(str);
+  format::binary::reader reader{std::move(in)};
+  std::vector<event> xs;
+  auto r = reader.read(xs, bro_http_log.size());
+  REQUIRE(r);
+  REQUIRE_EQUAL(xs.size(), bro_http_log.size());
+  CHECK(xs == bro_http_log);
+  CHECK(xs.front().type() == bro_http_log.front().type());
+  xs.clear();
+  r = reader.read(xs, std::numeric_limits<size_t>::max());
+  REQUIRE(!r);
+  CHECK(r.error() == ec::end_of_input);
+  REQUIRE_EQUAL(xs.size(), bgpdump_txt.size());
+  CHECK(xs == bgpdump_txt);
+  MESSAGE("rejecting a frame with a bogus size");
+  auto bogus = str.substr(0, format::binary::header_size);
+  std::fill(bogus.begin() + 8, bogus.end(), '\xff');
+  format::binary::reader corrupt{std::make_unique<std::istringstream>(bogus)};
+  auto e = corrupt.read();
+  REQUIRE(!e);
+  CHECK(e.error() == ec::format_error);
+}
+
 FIXTURE_SCOPE_END()
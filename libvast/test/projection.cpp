@@ -0,0 +1,98 @@
+#include "vast/event.hpp"
+#include "vast/projection.hpp"
+#include "vast/schema.hpp"
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/address.hpp"
+#include "vast/concept/parseable/vast/key.hpp"
+#include "vast/concept/parseable/vast/schema.hpp"
+
+#define SUITE projection
+#include "test.hpp"
+
+using namespace vast;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    auto s = to<schema>(R"__(
+      type conn = record{
+        uid: string,
+        id: record{ orig_h: addr, orig_p: port, resp_h: addr, resp_p: port },
+        service: string
+      }
+      type dns = record{ uid: string, query: string }
+    )__");
+    REQUIRE(s);
+    sch = std::move(*s);
+    auto conn = sch.find("conn");
+    auto dns = sch.find("dns");
+    REQUIRE(conn);
+    REQUIRE(dns);
+    auto orig_h = *to<address>("10.0.0.1");
+    auto resp_h = *to<address>("10.0.0.2");
+    auto id = vector{orig_h, port{1234, port::tcp}, resp_h, port{80, port::tcp}};
+    c = event::make(vector{"xyz", id, "http"}, *conn);
+    c.id(42);
+    c.timestamp(timestamp::clock::now());
+    d = event::make(vector{"abc", "vast.io"}, *dns);
+  }
+
+  projection make(std::vector<std::string> const& xs) {
+    std::vector<key> keys;
+    for (auto& x : xs) {
+      auto k = to<key>(x);
+      REQUIRE(k);
+      keys.push_back(std::move(*k));
+    }
+    return projection{std::move(keys)};
+  }
+
+  schema sch;
+  event c;
+  event d;
+};
+
+} // namespace <anonymous>
+
+FIXTURE_SCOPE(projection_tests, fixture)
+
+TEST(empty projection) {
+  projection p;
+  CHECK(p.empty());
+  auto x = p(c);
+  REQUIRE(x);
+  CHECK(*x == c);
+}
+
+TEST(nested fields) {
+  auto p = make({"id.orig_h", "id.resp_h"});
+  auto x = p(c);
+  REQUIRE(x);
+  CHECK_EQUAL(x->id(), c.id());
+  CHECK_EQUAL(x->timestamp(), c.timestamp());
+  CHECK_EQUAL(x->type().name(), "conn");
+  auto r = get_if<record_type>(x->type());
+  REQUIRE(r);
+  REQUIRE_EQUAL(r->fields.size(), 2u);
+  CHECK_EQUAL(r->fields[0].name, "id.orig_h");
+  CHECK_EQUAL(r->fields[1].name, "id.resp_h");
+  auto& xs = get<vector>(x->data());
+  CHECK(xs[0] == data{*to<address>("10.0.0.1")});
+  CHECK(xs[1] == data{*to<address>("10.0.0.2")});
+}
+
+TEST(suffix keys) {
+  auto p = make({"uid", "resp_p", "query"});
+  auto x = p(c);
+  REQUIRE(x);
+  CHECK(x->data() == vector{"xyz", port{80, port::tcp}});
+  auto y = p(d);
+  REQUIRE(y);
+  CHECK(y->data() == vector{"abc", "vast.io"});
+  MESSAGE("events without any selected field disappear");
+  auto q = make({"service"});
+  CHECK(!q(d));
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,147 @@
+#include <algorithm>
+
+#include "vast/event.hpp"
+#include "vast/expression.hpp"
+#include "vast/expression_visitors.hpp"
+#include "vast/query_matcher.hpp"
+#include "vast/schema.hpp"
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/expression.hpp"
+#include "vast/concept/parseable/vast/schema.hpp"
+
+#define SUITE query_matcher
+#include "test.hpp"
+
+using namespace vast;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    auto s = to<schema>(R"__(
+      type foo = record{ s1: string, d1: real, c: count }
+      type bar = record{ s1: string, r: record{ b: bool, s: string } }
+    )__");
+    REQUIRE(s);
+    sch = std::move(*s);
+    auto foo = sch.find("foo");
+    auto bar = sch.find("bar");
+    REQUIRE(foo);
+    REQUIRE(bar);
+    events.push_back(event::make(vector{"babba", 1.337, 42u}, *foo));
+    events.push_back(event::make(vector{"yadda", 0.5, 43u}, *foo));
+    events.push_back(event::make(vector{"yadda", vector{false, "baz"}}, *bar));
+    add(1, "c == 42");
+    add(2, "s1 in {\"babba\", \"yadda\"}");
+    add(3, "c == 42 && s1 == \"babba\"");
+    add(4, "c == 43 || d1 > 1.0");
+    add(5, "! (c == 42)");
+    add(6, "&type == \"bar\"");
+    add(7, "c == 42 && s1 == \"nope\"");
+    add(8, "s1 == \"yadda\" && r.b == F");
+  }
+
+  void add(query_matcher::query_id id, std::string const& str) {
+    auto expr = to<expression>(str);
+    REQUIRE(expr);
+    auto normalized = normalize_and_validate(*expr);
+    REQUIRE(normalized);
+    CHECK(matcher.add(id, *normalized));
+    queries.emplace_back(id, std::move(*normalized));
+  }
+
+  // Evaluates all queries one by one, as an exporter would.
+  std::vector<query_matcher::query_id> evaluate(event const& e) {
+    std::vector<query_matcher::query_id> result;
+    for (auto& q : queries) {
+      auto x = tailor(q.second, e.type());
+      if (x && visit(vast::matcher{e.type()}, *x)
+          && visit(event_evaluator{e}, *x))
+        result.push_back(q.first);
+    }
+    return result;
+  }
+
+  std::vector<query_matcher::query_id> match(event const& e) {
+    std::vector<query_matcher::query_id> result;
+    matcher.match(e, result);
+    return result;
+  }
+
+  schema sch;
+  std::vector<event> events;
+  std::vector<std::pair<query_matcher::query_id, expression>> queries;
+  query_matcher matcher;
+};
+
+using ids = std::vector<query_matcher::query_id>;
+
+} // namespace <anonymous>
+
+FIXTURE_SCOPE(query_matcher_tests, fixture)
+
+TEST(matching standing queries) {
+  CHECK_EQUAL(matcher.size(), 8u);
+  CHECK(!matcher.add(1, expression{}));
+  CHECK(match(events[0]) == (ids{1, 2, 3, 4}));
+  CHECK(match(events[1]) == (ids{2, 4, 5}));
+  auto xs = match(events[2]);
+  CHECK(std::find(xs.begin(), xs.end(), 2) != xs.end());
+  CHECK(std::find(xs.begin(), xs.end(), 6) != xs.end());
+  CHECK(std::find(xs.begin(), xs.end(), 8) != xs.end());
+  MESSAGE("agree with separate evaluation");
+  for (auto& e : events)
+    CHECK(match(e) == evaluate(e));
+}
+
+TEST(removing standing queries) {
+  CHECK(matcher.remove(2));
+  CHECK(!matcher.remove(2));
+  CHECK(match(events[1]) == (ids{4, 5}));
+  CHECK(matcher.remove(1));
+  CHECK(matcher.remove(3));
+  CHECK(matcher.remove(4));
+  CHECK(matcher.remove(5));
+  CHECK(matcher.remove(6));
+  CHECK(matcher.remove(7));
+  CHECK(matcher.remove(8));
+  CHECK(matcher.empty());
+  CHECK(match(events[0]).empty());
+}
+
+TEST(updating compiled queries) {
+  auto remove = [&](query_matcher::query_id id) {
+    CHECK(matcher.remove(id));
+    auto pred = [&](auto& x) { return x.first == id; };
+    queries.erase(std::remove_if(queries.begin(), queries.end(), pred),
+                  queries.end());
+  };
+  // Compile the queries for all types, so that the following updates modify
+  // the compiled types in place.
+  for (auto& e : events)
+    match(e);
+  MESSAGE("adding queries after compilation");
+  add(9, "s1 == \"babba\" && c == 42");
+  add(10, "! (s1 == \"yadda\")");
+  for (auto& e : events)
+    CHECK(match(e) == evaluate(e));
+  MESSAGE("removing queries after compilation");
+  remove(1);
+  remove(4);
+  for (auto& e : events)
+    CHECK(match(e) == evaluate(e));
+  MESSAGE("removing enough queries to trigger recompilation");
+  remove(3);
+  remove(5);
+  remove(7);
+  remove(8);
+  for (auto& e : events)
+    CHECK(match(e) == evaluate(e));
+  MESSAGE("reviving the predicates of removed queries");
+  add(11, "c == 43 || d1 > 1.0");
+  add(12, "c == 42");
+  for (auto& e : events)
+    CHECK(match(e) == evaluate(e));
+}
+
+FIXTURE_SCOPE_END()
@@ -14,10 +14,10 @@ FIXTURE_SCOPE(archive_tests, fixtures::actor_system_and_events)
 TEST(archiving and querying) {
   auto a = self->spawn(system::archive, directory, 10, 1024 * 1024);
   MESSAGE("sending events");
-  self->send(a, bro_conn_log);
-  self->send(a, bro_dns_log);
-  self->send(a, bro_http_log);
-  self->send(a, bgpdump_txt);
+  self->send(a, event_slice{bro_conn_log});
+  self->send(a, event_slice{bro_dns_log});
+  self->send(a, event_slice{bro_http_log});
+  self->send(a, event_slice{bgpdump_txt});
   MESSAGE("querying event set {[100,150), [10150,10200)}");
   bitmap bm;
   bm.append_bits(false, 100);
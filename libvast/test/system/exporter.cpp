@@ -1,11 +1,17 @@
+#include <algorithm>
+
+#include "vast/checker.hpp"
 #include "vast/concept/parseable/to.hpp"
 #include "vast/concept/parseable/vast/expression.hpp"
 #include "vast/query_options.hpp"
 
 #include "vast/system/archive.hpp"
 #include "vast/system/archive.hpp"
+#include "vast/system/data_store.hpp"
 #include "vast/system/exporter.hpp"
+#include "vast/system/importer.hpp"
 #include "vast/system/index.hpp"
+#include "vast/system/stream_matcher.hpp"
 
 #define SUITE export
 #include "test.hpp"
@@ -15,14 +21,26 @@ using namespace caf;
 using namespace vast;
 using namespace std::chrono;
 
+namespace {
+
+bool newest_first(event const& x, event const& y) {
+  return x.timestamp() > y.timestamp();
+}
+
+bool oldest_first_order(event const& x, event const& y) {
+  return x.timestamp() < y.timestamp();
+}
+
+} // namespace <anonymous>
+
 FIXTURE_SCOPE(exporter_tests, fixtures::actor_system_and_events)
 
 TEST(exporter) {
   auto i = self->spawn(system::index, directory / "index", 1000, 5, 5);
   auto a = self->spawn(system::archive, directory / "archive", 1, 1024);
   MESSAGE("ingesting conn.log");
-  self->send(i, bro_conn_log);
-  self->send(a, bro_conn_log);
+  self->send(i, event_slice{bro_conn_log});
+  self->send(a, event_slice{bro_conn_log});
   auto expr = to<expression>("service == \"http\" && :addr == 212.227.96.110");
   REQUIRE(expr);
   MESSAGE("issueing query");
@@ -36,16 +54,225 @@ TEST(exporter) {
   std::vector<event> results;
   self->do_receive(
     [&](std::vector<event>& xs) {
+      // Each batch of results arrives in time order, most recent first.
+      CHECK(std::is_sorted(xs.begin(), xs.end(), newest_first));
       std::move(xs.begin(), xs.end(), std::back_inserter(results));
     },
     error_handler()
   ).until([&] { return results.size() == 28; });
   MESSAGE("sanity checking result correctness");
-  CHECK_EQUAL(results.front().id(), 105u);
-  CHECK_EQUAL(results.front().type().name(), "bro::conn");
-  CHECK_EQUAL(results.back().id(), 8354u);
+  auto by_id = [](event const& x, event const& y) { return x.id() < y.id(); };
+  auto ids = std::minmax_element(results.begin(), results.end(), by_id);
+  CHECK_EQUAL(ids.first->id(), 105u);
+  CHECK_EQUAL(ids.first->type().name(), "bro::conn");
+  CHECK_EQUAL(ids.second->id(), 8354u);
+  self->send_exit(i, exit_reason::user_shutdown);
+  self->send_exit(a, exit_reason::user_shutdown);
+}
+
+TEST(exporter limit) {
+  auto i = self->spawn(system::index, directory / "index", 1000, 5, 5);
+  auto a = self->spawn(system::archive, directory / "archive", 1, 1024);
+  MESSAGE("ingesting conn.log");
+  self->send(i, event_slice{bro_conn_log});
+  self->send(a, event_slice{bro_conn_log});
+  auto expr = to<expression>("service == \"http\" && :addr == 212.227.96.110");
+  REQUIRE(expr);
+  // Determine all hits in ID order, i.e., from oldest to most recent.
+  std::vector<event_id> hits;
+  auto check = make_checker(*expr, bro_conn_log.front().type());
+  REQUIRE(check);
+  for (auto& x : bro_conn_log)
+    if ((*check)(x))
+      hits.push_back(x.id());
+  REQUIRE_EQUAL(hits.size(), 28u);
+  auto run = [&](query_options opts) {
+    auto e = self->spawn(system::exporter, *expr, opts);
+    self->monitor(e);
+    self->send(e, a);
+    self->send(e, system::index_atom::value, i);
+    self->send(e, system::sink_atom::value, self);
+    self->send(e, system::run_atom::value);
+    self->send(e, system::limit_atom::value, uint64_t{10});
+    std::vector<event> results;
+    auto done = false;
+    self->do_receive(
+      [&](std::vector<event>& xs) {
+        std::move(xs.begin(), xs.end(), std::back_inserter(results));
+      },
+      [&](uuid const&, system::query_statistics const&) {
+        // nop
+      },
+      [&](down_msg const& msg) {
+        CHECK(msg.source == e.address());
+        done = true;
+      },
+      error_handler()
+    ).until([&] { return done; });
+    return results;
+  };
+  auto sorted_ids = [](std::vector<event> const& xs) {
+    std::vector<event_id> result;
+    for (auto& x : xs)
+      result.push_back(x.id());
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+  MESSAGE("limiting to the 10 most recent results");
+  auto results = run(historical);
+  REQUIRE_EQUAL(results.size(), 10u);
+  CHECK(std::is_sorted(results.begin(), results.end(), newest_first));
+  auto newest = std::vector<event_id>(hits.end() - 10, hits.end());
+  CHECK_EQUAL(sorted_ids(results), newest);
+  CHECK_EQUAL(sorted_ids(results).back(), 8354u);
+  MESSAGE("limiting to the 10 oldest results");
+  results = run(historical + oldest_first);
+  REQUIRE_EQUAL(results.size(), 10u);
+  CHECK(std::is_sorted(results.begin(), results.end(), oldest_first_order));
+  auto oldest = std::vector<event_id>(hits.begin(), hits.begin() + 10);
+  CHECK_EQUAL(sorted_ids(results), oldest);
+  CHECK_EQUAL(sorted_ids(results).front(), 105u);
+  self->send_exit(i, exit_reason::user_shutdown);
+  self->send_exit(a, exit_reason::user_shutdown);
+}
+
+TEST(exporter count) {
+  auto i = self->spawn(system::index, directory / "index", 1000, 5, 5);
+  MESSAGE("ingesting conn.log");
+  self->send(i, event_slice{bro_conn_log});
+  auto expr = to<expression>("service == \"http\" && :addr == 212.227.96.110");
+  REQUIRE(expr);
+  auto run = [&](actor const& idx, auto&&... args) {
+    auto e = self->spawn(system::exporter, *expr, historical);
+    self->send(e, system::index_atom::value, idx);
+    self->send(e, system::sink_atom::value, self);
+    self->send(e, system::count_atom::value, args...);
+    self->send(e, system::run_atom::value);
+    self->send(e, system::extract_atom::value);
+    std::vector<event> results;
+    self->receive(
+      [&](std::vector<event>& xs) { results = std::move(xs); },
+      error_handler()
+    );
+    return results;
+  };
+  MESSAGE("counting results without an archive");
+  auto results = run(i);
+  REQUIRE_EQUAL(results.size(), 1u);
+  CHECK_EQUAL(results[0].type().name(), "vast::count");
+  CHECK(results[0].data() == vector{count{28}});
+  MESSAGE("counting results per type");
+  results = run(i, std::string{"&type"});
+  REQUIRE_EQUAL(results.size(), 1u);
+  CHECK_EQUAL(results[0].type().name(), "vast::group");
+  CHECK(results[0].data() == vector{std::string{"bro::conn"}, count{28}});
+  MESSAGE("counting results without any partition");
+  auto empty = self->spawn(system::index, directory / "empty", 1000, 5, 5);
+  results = run(empty);
+  REQUIRE_EQUAL(results.size(), 1u);
+  CHECK(results[0].data() == vector{count{0}});
+  self->send_exit(empty, exit_reason::user_shutdown);
+  self->send_exit(i, exit_reason::user_shutdown);
+}
+
+TEST(exporter count verification) {
+  auto i = self->spawn(system::index, directory / "index", 1000, 5, 5);
+  auto a = self->spawn(system::archive, directory / "archive", 1, 1024);
+  MESSAGE("ingesting conn.log");
+  self->send(i, event_slice{bro_conn_log});
+  self->send(a, event_slice{bro_conn_log});
+  // The index bins timestamps, so it cannot count this query exactly.
+  auto expr = to<expression>("&time > 2009-11-18+08:05:00 && :port == 80/tcp");
+  REQUIRE(expr);
+  auto check = make_checker(*expr, bro_conn_log.front().type());
+  REQUIRE(check);
+  auto expected = std::count_if(bro_conn_log.begin(), bro_conn_log.end(),
+                                [&](event const& x) { return (*check)(x); });
+  auto e = self->spawn(system::exporter, *expr, historical);
+  self->send(e, a);
+  self->send(e, system::index_atom::value, i);
+  self->send(e, system::sink_atom::value, self);
+  self->send(e, system::count_atom::value);
+  self->send(e, system::run_atom::value);
+  self->send(e, system::extract_atom::value);
+  MESSAGE("counting the results of the candidate check");
+  self->receive(
+    [&](std::vector<event>& xs) {
+      REQUIRE_EQUAL(xs.size(), 1u);
+      CHECK(xs[0].data() == vector{count(expected)});
+    },
+    error_handler()
+  );
+  MESSAGE("grouping by a non-boolean field");
+  e = self->spawn(system::exporter, *expr, historical);
+  self->monitor(e);
+  self->send(e, system::index_atom::value, i);
+  self->send(e, system::sink_atom::value, self);
+  self->send(e, system::count_atom::value, std::string{"service"});
+  self->send(e, system::run_atom::value);
+  self->send(e, system::extract_atom::value);
+  auto done = false;
+  self->do_receive(
+    [&](uuid const&, system::query_statistics const&) {
+      // nop
+    },
+    [&](down_msg const& msg) {
+      CHECK(msg.reason == ec::type_clash);
+      done = true;
+    }
+  ).until([&] { return done; });
   self->send_exit(i, exit_reason::user_shutdown);
   self->send_exit(a, exit_reason::user_shutdown);
 }
 
+TEST(continuous exporter) {
+  auto store = self->spawn(system::data_store<std::string, data>);
+  auto importer = self->spawn(system::importer, directory / "importer", 1024);
+  auto matcher = self->spawn(system::stream_matcher);
+  self->send(importer, store);
+  self->send(importer, actor_cast<system::archive_type>(self));
+  self->send(importer, system::index_atom::value, self);
+  self->send(importer, system::matcher_atom::value, matcher);
+  auto expr = to<expression>("service == \"http\" && :addr == 212.227.96.110");
+  REQUIRE(expr);
+  auto e = self->spawn(system::exporter, *expr, continuous);
+  self->send(e, system::sink_atom::value, self);
+  self->send(e, system::matcher_atom::value, matcher);
+  self->send(e, system::run_atom::value);
+  self->send(e, system::extract_atom::value);
+  // Imports conn.log once, acting as archive and index, and collects the
+  // matches until the system goes quiet.
+  std::vector<event> results;
+  auto import = [&] {
+    self->send(importer, bro_conn_log);
+    auto idle = false;
+    while (!idle)
+      self->receive(
+        [&](event_slice const&) { return ok_atom::value; },
+        [&](ok_atom) {
+          // nop
+        },
+        [&](std::vector<event>& xs) {
+          std::move(xs.begin(), xs.end(), std::back_inserter(results));
+        },
+        after(milliseconds(200)) >> [&] { idle = true; }
+      );
+  };
+  MESSAGE("importing until the subscription takes effect");
+  for (auto i = 0; i < 50 && results.empty(); ++i)
+    import();
+  REQUIRE(!results.empty());
+  MESSAGE("receiving all matches of an import");
+  results.clear();
+  import();
+  CHECK_EQUAL(results.size(), 28u);
+  CHECK(std::all_of(results.begin(), results.end(), [](event const& x) {
+    return x.type().name() == "bro::conn";
+  }));
+  self->send_exit(e, exit_reason::user_shutdown);
+  self->send_exit(importer, exit_reason::user_shutdown);
+  self->send_exit(matcher, exit_reason::user_shutdown);
+  self->send_exit(store, exit_reason::user_shutdown);
+}
+
 FIXTURE_SCOPE_END()
@@ -27,7 +27,7 @@ TEST(importer) {
   MESSAGE("receiving reflected events");
   for (auto i = 0; i < 4; ++i)
     self->receive(
-      [&](const std::vector<event>&) { },
+      [&](const event_slice&) { return ok_atom::value; },
       error_handler()
     );
   self->send_exit(importer, exit_reason::user_shutdown);
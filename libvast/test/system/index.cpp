@@ -19,14 +19,35 @@ namespace {
 
 FIXTURE_SCOPE(index_tests, fixtures::actor_system_and_events)
 
+TEST(partition index time order) {
+  system::partition_index idx;
+  auto add = [&](seconds ts) {
+    auto e = event::make(count{42}, count_type{});
+    e.timestamp(timestamp{ts});
+    auto id = uuid::random();
+    idx.add(event_slice{std::vector<event>{e}}, id);
+    return id;
+  };
+  auto x = add(seconds{100});
+  auto y = add(seconds{10});
+  auto z = add(seconds{1000});
+  auto expr = to<expression>(":count == 42");
+  REQUIRE(expr);
+  auto partitions = idx.lookup(*expr);
+  REQUIRE_EQUAL(partitions.size(), 3u);
+  CHECK_EQUAL(partitions[0], y);
+  CHECK_EQUAL(partitions[1], x);
+  CHECK_EQUAL(partitions[2], z);
+}
+
 TEST(index) {
   directory /= "index";
   MESSAGE("spawing");
   auto index = self->spawn(system::index, directory, 1000, 5, 10);
   MESSAGE("indexing logs");
-  self->send(index, bro_conn_log);
-  self->send(index, bro_dns_log);
-  self->send(index, bro_http_log);
+  self->send(index, event_slice{bro_conn_log});
+  self->send(index, event_slice{bro_dns_log});
+  self->send(index, event_slice{bro_http_log});
   MESSAGE("issueing queries");
   auto expr = to<expression>(":addr == 74.125.19.100");
   REQUIRE(expr);
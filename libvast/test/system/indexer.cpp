@@ -5,6 +5,7 @@
 #include "vast/concept/printable/vast/event.hpp"
 #include "vast/concept/printable/vast/expression.hpp"
 #include "vast/bitmap.hpp"
+#include "vast/event_slice.hpp"
 
 #include "vast/system/indexer.hpp"
 
@@ -22,7 +23,7 @@ TEST(indexer) {
   const auto conn_log_type = bro_conn_log[0].type();
   auto i = self->spawn(system::event_indexer, directory, conn_log_type);
   MESSAGE("ingesting events");
-  self->send(i, bro_conn_log);
+  self->send(i, event_slice{bro_conn_log});
   // Event indexers operate with predicates, whereas partitions take entire
   // expressions.
   MESSAGE("querying");
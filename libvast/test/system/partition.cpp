@@ -1,6 +1,7 @@
 #include "vast/bitmap.hpp"
 #include "vast/concept/parseable/to.hpp"
 #include "vast/concept/parseable/vast/expression.hpp"
+#include "vast/event_slice.hpp"
 
 #include "vast/system/partition.hpp"
 #include "vast/system/task.hpp"
@@ -20,11 +21,11 @@ struct partition_fixture : fixtures::actor_system_and_events {
     directory /= "partition";
     MESSAGE("ingesting conn.log");
     partition = self->spawn(system::partition, directory);
-    self->send(partition, bro_conn_log);
+    self->send(partition, event_slice{bro_conn_log});
     MESSAGE("ingesting http.log");
-    self->send(partition, bro_http_log);
+    self->send(partition, event_slice{bro_http_log});
     MESSAGE("ingesting bgpdump log");
-    self->send(partition, bgpdump_txt);
+    self->send(partition, event_slice{bgpdump_txt});
     MESSAGE("completed ingestion");
   }
 
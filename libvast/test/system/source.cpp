@@ -1,6 +1,11 @@
+#include <unistd.h>
+
+#include <fstream>
+
 #include "vast/format/bro.hpp"
 #include "vast/system/source.hpp"
 
+#include "vast/detail/fdinbuf.hpp"
 #include "vast/detail/make_io_stream.hpp"
 
 #define SUITE system
@@ -31,4 +36,89 @@ TEST(Bro source) {
   });
 }
 
+TEST(adaptive batch size) {
+  using std::chrono::milliseconds;
+  auto adapt = [](uint64_t size, uint64_t events, timespan runtime,
+                  bool congested = false) {
+    return adapt_batch_size(size, events, runtime, milliseconds(100),
+                            congested, 128, 1 << 20);
+  };
+  MESSAGE("fast feeds grow at most by a factor of two");
+  CHECK_EQUAL(adapt(1000, 1000, milliseconds(1)), 2000u);
+  CHECK_EQUAL(adapt(1 << 20, 1 << 20, milliseconds(1)), 1u << 20);
+  MESSAGE("slow feeds shrink towards the latency target");
+  CHECK_EQUAL(adapt(1000, 1000, milliseconds(1000)), 550u);
+  CHECK_EQUAL(adapt(200, 10, milliseconds(1000)), 128u);
+  MESSAGE("matching feeds stay put");
+  CHECK_EQUAL(adapt(1000, 1000, milliseconds(100)), 1000u);
+  MESSAGE("congestion prevents shrinking");
+  CHECK_EQUAL(adapt(1000, 1000, milliseconds(1000), true), 1000u);
+}
+
+TEST(source backpressure) {
+  auto stream = detail::make_input_stream(bro::conn);
+  REQUIRE(stream);
+  format::bro::reader reader{std::move(*stream)};
+  auto src = self->spawn(source<format::bro::reader>, std::move(reader));
+  self->send(src, sink_atom::value, self);
+  self->send(src, batch_atom::value, uint64_t{1000});
+  self->send(src, credit_atom::value, uint64_t{2});
+  self->send(src, run_atom::value);
+  MESSAGE("receiving batches up to the credit limit");
+  std::vector<caf::response_promise> acks;
+  auto receive_batch = [&] {
+    self->receive([&](std::vector<event> const& events) {
+      CHECK_EQUAL(events.size(), 1000u);
+      acks.push_back(self->make_response_promise());
+    });
+  };
+  receive_batch();
+  receive_batch();
+  self->receive(
+    [&](std::vector<event> const&) {
+      FAIL("source shipped a batch without credit");
+    },
+    caf::after(std::chrono::milliseconds(100)) >> [] { }
+  );
+  MESSAGE("returning credit for one batch");
+  acks[0].deliver(ok_atom::value);
+  receive_batch();
+  self->send_exit(src, caf::exit_reason::user_shutdown);
+}
+
+TEST(source partial batch) {
+  // Feed the header and 100 records of a log through a pipe that stays open.
+  // The source must ship the records without waiting for more input.
+  int fds[2];
+  REQUIRE_EQUAL(::pipe(fds), 0);
+  std::ifstream log{bro::conn};
+  std::string input;
+  std::string line;
+  for (auto i = 0; i < 108 && std::getline(log, line); ++i)
+    input += line + '\n';
+  REQUIRE_EQUAL(::write(fds[1], input.data(), input.size()),
+                static_cast<ssize_t>(input.size()));
+  auto sb = std::make_unique<detail::fdinbuf>(fds[0]);
+  auto stream = std::make_unique<std::istream>(sb.release());
+  format::bro::reader reader{std::move(stream)};
+  auto src = self->spawn(source<format::bro::reader>, std::move(reader));
+  self->monitor(src);
+  self->send(src, sink_atom::value, self);
+  self->send(src, run_atom::value);
+  self->receive(
+    [&](std::vector<event> const& events) {
+      CHECK_EQUAL(events.size(), 100u);
+    },
+    caf::after(std::chrono::seconds(10)) >> [] {
+      FAIL("source held back a partial batch");
+    }
+  );
+  MESSAGE("closing the pipe ends the source");
+  ::close(fds[1]);
+  self->receive([&](caf::down_msg const& msg) {
+    CHECK(msg.reason == caf::exit_reason::normal);
+  });
+  ::close(fds[0]);
+}
+
 FIXTURE_SCOPE_END()
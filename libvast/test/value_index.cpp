@@ -166,6 +166,48 @@ TEST(timestamp) {
   CHECK(to_string(*eighteen) == "000101");
 }
 
+TEST(timestamp index) {
+  timestamp_index idx;
+  arithmetic_index<timestamp> ref{base::uniform<64>(10)};
+  auto push = [&](auto x, event_id id) {
+    REQUIRE(idx.push_back(x, id));
+    REQUIRE(ref.push_back(x, id));
+  };
+  MESSAGE("push_back in and out of order");
+  auto t = to<timestamp>("2014-01-16+05:30:15");
+  REQUIRE(t);
+  push(*t, 0);
+  push(*t + std::chrono::seconds(3), 1);
+  push(*t - std::chrono::seconds(2), 2);
+  push(nil, 3);
+  push(*t + std::chrono::seconds(3), 5);
+  push(*t + std::chrono::milliseconds(3500), 6);
+  push(*t, 7);
+  push(*t + std::chrono::seconds(4), 10);
+  MESSAGE("lookup agrees with the arithmetic index");
+  auto check = [&](timestamp_index const& x) {
+    for (auto op : {less, less_equal, equal, not_equal, greater_equal, greater})
+      for (auto delta = -3; delta <= 5; ++delta) {
+        auto y = *t + std::chrono::seconds(delta);
+        auto result = x.lookup(op, y);
+        auto expected = ref.lookup(op, y);
+        REQUIRE(result);
+        REQUIRE(expected);
+        CHECK_EQUAL(to_string(*result), to_string(*expected));
+      }
+  };
+  check(idx);
+  CHECK_EQUAL(to_string(*idx.lookup(equal, *t)), "10000001000");
+  CHECK_EQUAL(to_string(*idx.lookup(less, *t)), "00100000000");
+  CHECK(!idx.lookup(in, *t));
+  MESSAGE("serialization");
+  std::vector<char> buf;
+  save(buf, idx);
+  auto idx2 = timestamp_index{};
+  load(buf, idx2);
+  check(idx2);
+}
+
 TEST(string) {
   string_index idx{100};
   MESSAGE("push_back");
@@ -374,6 +416,39 @@ TEST(container) {
   CHECK_EQUAL(to_string(*idx2.lookup(in, "bar")), "10110001");
 }
 
+TEST(container elements) {
+  element_index idx{string_type{}};
+  MESSAGE("push_back");
+  vector v{"foo", "bar"};
+  REQUIRE(idx.push_back(v));
+  v = {"qux", "foo", "baz", "corge"};
+  REQUIRE(idx.push_back(v));
+  v = {"bar"};
+  REQUIRE(idx.push_back(v));
+  REQUIRE(idx.push_back(vector{}));
+  REQUIRE(idx.push_back(v, 7));
+  v.clear();
+  for (auto i = 0; i < 500; ++i)
+    v.emplace_back(std::to_string(i));
+  v.emplace_back("foo");
+  REQUIRE(idx.push_back(v));
+  MESSAGE("lookup");
+  CHECK_EQUAL(to_string(*idx.lookup(in, "foo")), "110000001");
+  CHECK_EQUAL(to_string(*idx.lookup(in, "bar")), "101000010");
+  CHECK_EQUAL(to_string(*idx.lookup(ni, "bar")), "101000010");
+  CHECK_EQUAL(to_string(*idx.lookup(not_in, "foo")), "001100010");
+  CHECK_EQUAL(to_string(*idx.lookup(in, "42")), "000000001");
+  CHECK_EQUAL(to_string(*idx.lookup(in, "not")), "000000000");
+  CHECK(!idx.lookup(equal, "foo"));
+  MESSAGE("serialization");
+  std::vector<char> buf;
+  save(buf, idx);
+  element_index idx2;
+  load(buf, idx2);
+  CHECK_EQUAL(to_string(*idx2.lookup(in, "foo")), "110000001");
+  CHECK_EQUAL(to_string(*idx2.lookup(in, "bar")), "101000010");
+}
+
 TEST(polymorphic) {
   type t = set_type{integer_type{}}.attributes({{"max_size", "2"}});
   auto idx = value_index::make(t);
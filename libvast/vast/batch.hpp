@@ -109,12 +109,18 @@ public:
   /// @returns The set events according to *ids*.
   expected<std::vector<event>> read(const bitmap& ids);
 
+  /// Extracts events according to an indexed bitmap.
+  /// @param ids The skip index over the set of event IDs.
+  /// @returns The set events according to *ids*.
+  expected<std::vector<event>> read(const bitmap_skip_index& ids);
+
 private:
   expected<event> materialize();
 
   buffer_type const& data_;
   std::unordered_map<uint32_t, type> type_cache_;
   select_range<bitmap_bit_range> id_range_;
+  event_id last_;
   size_type available_;
   caf::charbuf charbuf_;
   detail::compressedbuf compressedbuf_;
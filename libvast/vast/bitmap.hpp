@@ -1,6 +1,8 @@
 #ifndef VAST_BITMAP_HPP
 #define VAST_BITMAP_HPP
 
+#include <memory>
+
 #include "vast/bitmap_base.hpp"
 #include "vast/detail/type_traits.hpp"
 #include "vast/ewah_bitmap.hpp"
@@ -96,6 +98,69 @@ private:
 
 bitmap_bit_range bit_range(bitmap const& bm);
 
+// -- bitwise operations ------------------------------------------------------
+//
+// When both operands wrap EWAH bitmaps, these overloads dispatch to the
+// specialized EWAH algorithms and otherwise fall back to the generic ones.
+
+bitmap binary_and(bitmap const& lhs, bitmap const& rhs);
+
+bitmap binary_or(bitmap const& lhs, bitmap const& rhs);
+
+bitmap binary_xor(bitmap const& lhs, bitmap const& rhs);
+
+bitmap binary_nand(bitmap const& lhs, bitmap const& rhs);
+
+/// Evaluates a chain of bitwise operations in a single pass if all operands
+/// wrap EWAH bitmaps and falls back to the generic algorithm otherwise.
+/// @relates chain_eval
+bitmap chain_eval(bitmap const& x, bitwise_chain<bitmap> const& ys);
+
+/// Computes the *rank* of the concrete bitmap.
+/// @relates rank
+template <bool Bit = true>
+bitmap::size_type rank(bitmap const& bm, bitmap::size_type i);
+
+/// Computes the position of the *i*-th occurrence of a bit in the concrete
+/// bitmap.
+/// @relates select
+template <bool Bit = true>
+bitmap::size_type select(bitmap const& bm, bitmap::size_type i);
+
+/// A skip index over a type-erased bitmap for repeated *rank* and *select*
+/// queries. If the bitmap wraps an EWAH bitmap, the index uses an
+/// ::ewah_skip_index and otherwise falls back to the linear-time algorithms.
+/// The bitmap must outlive the index and must not change during its lifetime.
+class bitmap_skip_index {
+public:
+  using size_type = bitmap::size_type;
+  using word_type = bitmap::word_type;
+
+  /// Constructs a skip index for a bitmap. The construction is cheap, as the
+  /// index only materializes on demand.
+  /// @param bm The bitmap to index.
+  explicit bitmap_skip_index(bitmap const& bm);
+
+  /// @see ewah_skip_index::rank
+  template <bool Bit = true>
+  size_type rank(size_type i) const;
+
+  /// @see ewah_skip_index::rank
+  template <bool Bit = true>
+  size_type rank() const;
+
+  /// @see ewah_skip_index::select
+  template <bool Bit = true>
+  size_type select(size_type i) const;
+
+  /// @see ewah_skip_index::find_next
+  size_type find_next(size_type i) const;
+
+private:
+  bitmap const* bm_;
+  std::unique_ptr<ewah_skip_index> ewah_;
+};
+
 } // namespace vast
 
 #endif
@@ -5,9 +5,12 @@
 #include <iterator>
 #include <queue>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "vast/aliases.hpp"
 #include "vast/bits.hpp"
+#include "vast/operator.hpp"
 #include "vast/optional.hpp"
 #include "vast/detail/assert.hpp"
 #include "vast/detail/range.hpp"
@@ -217,24 +220,82 @@ auto binary_nor(LHS const& lhs, RHS const& rhs) {
   return binary_eval<true, true>(lhs, rhs, op);
 }
 
-template <class Iterator>
-auto nary_and(Iterator begin, Iterator end) {
+// The 3-argument overloads of nary_and and nary_or dispatch on the bitmap
+// type of the input sequence. Bitmap types with a specialized n-ary algorithm
+// provide a more specialized overload for their type.
+
+template <class Iterator, class Bitmap>
+auto nary_and(Iterator begin, Iterator end, Bitmap const*) {
   auto op = [](auto x, auto y) { return x & y; };
   return nary_eval(begin, end, op);
 }
 
-template <class Iterator>
-auto nary_or(Iterator begin, Iterator end) {
+template <class Iterator, class Bitmap>
+auto nary_or(Iterator begin, Iterator end, Bitmap const*) {
   auto op = [](auto x, auto y) { return x | y; };
   return nary_eval(begin, end, op);
 }
 
+template <class Iterator>
+auto nary_and(Iterator begin, Iterator end) {
+  using bitmap_type = std::decay_t<decltype(*begin)>;
+  return nary_and(begin, end, static_cast<bitmap_type const*>(nullptr));
+}
+
+template <class Iterator>
+auto nary_or(Iterator begin, Iterator end) {
+  using bitmap_type = std::decay_t<decltype(*begin)>;
+  return nary_or(begin, end, static_cast<bitmap_type const*>(nullptr));
+}
+
 template <class Iterator>
 auto nary_xor(Iterator begin, Iterator end) {
   auto op = [](auto x, auto y) { return x ^ y; };
   return nary_eval(begin, end, op);
 }
 
+/// A sequence of operations in a left-deep chain of bitwise operations. Each
+/// element consists of an operator and the (non-owned) right-hand side bitmap
+/// to apply it to. Valid operators are `bitwise_and`, `bitwise_or`,
+/// `bitwise_xor`, and `minus`, which correspond to the respective in-place
+/// operators of a bitmap.
+template <class Bitmap>
+using bitwise_chain =
+  std::vector<std::pair<arithmetic_operator, Bitmap const*>>;
+
+/// Evaluates a left-deep chain of bitwise operations, i.e., computes
+/// *((x op1 y1) op2 y2) ... opN yN* for a sequence of *(opI, yI)* pairs.
+/// Bitmap types that can evaluate the chain in a single pass over all
+/// operands provide a specialized overload; this generic version materializes
+/// every intermediate result.
+/// @param x The initial bitmap.
+/// @param ys The sequence of operations to apply.
+/// @returns The result of the chain evaluation.
+/// @pre All bitmaps have the same size.
+template <class Bitmap>
+Bitmap chain_eval(Bitmap const& x, bitwise_chain<Bitmap> const& ys) {
+  auto result = x;
+  for (auto& y : ys)
+    switch (y.first) {
+      default:
+        VAST_ASSERT(!"invalid bitwise operator");
+        break;
+      case bitwise_and:
+        result &= *y.second;
+        break;
+      case bitwise_or:
+        result |= *y.second;
+        break;
+      case bitwise_xor:
+        result ^= *y.second;
+        break;
+      case minus:
+        result -= *y.second;
+        break;
+    }
+  return result;
+}
+
 /// Computes the *rank* of a Bitmap, i.e., the number of occurrences of a bit
 /// value in *B[0,i]*.
 /// @tparam Bit The bit value to count.
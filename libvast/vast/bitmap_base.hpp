@@ -164,27 +164,27 @@ public:
   //
   // Derived types should provide an optimized version where possible.
 
-  Derived& operator&=(Derived const rhs) {
+  Derived& operator&=(Derived const& rhs) {
     derived() = derived() & rhs;
     return derived();
   }
 
-  Derived& operator|=(Derived const rhs) {
+  Derived& operator|=(Derived const& rhs) {
     derived() = derived() | rhs;
     return derived();
   }
 
-  Derived& operator^=(Derived const rhs) {
+  Derived& operator^=(Derived const& rhs) {
     derived() = derived() ^ rhs;
     return derived();
   }
 
-  Derived& operator-=(Derived const rhs) {
+  Derived& operator-=(Derived const& rhs) {
     derived() = derived() - rhs;
     return derived();
   }
 
-  Derived& operator/=(Derived const rhs) {
+  Derived& operator/=(Derived const& rhs) {
     derived() = derived() / rhs;
     return derived();
   }
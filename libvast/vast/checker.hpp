@@ -0,0 +1,66 @@
+#ifndef VAST_CHECKER_HPP
+#define VAST_CHECKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "vast/expected.hpp"
+#include "vast/expression.hpp"
+
+namespace vast {
+
+class event;
+class type;
+
+/// An expression compiled for checking events of a single type. Compilation
+/// tailors the expression to the type, resolves all extractors to fixed
+/// offsets or constants, and selects a typed comparison function for each
+/// predicate based on its operator and RHS. Checking an event then runs a tree
+/// of closures instead of walking and re-dispatching over the expression AST.
+///
+/// A checker also evaluates entire batches of events. In this mode it
+/// extracts the operand of a predicate for all events at once and compares
+/// arithmetic, time, address, and port values in tight loops over a column.
+class checker {
+public:
+  /// Constructs a checker that rejects all events.
+  checker() = default;
+
+  /// Checks whether an event satisfies the compiled expression.
+  /// @param e The event to check, which must have the type of the checker.
+  /// @returns `true` iff *e* satisfies the expression.
+  bool operator()(event const& e) const;
+
+  /// Checks a batch of events, one predicate at a time.
+  /// @param xs The events to check, which must have the type of the checker.
+  /// @param n The number of events in *xs*.
+  /// @param result The vector to append one entry per event to, which is 1
+  ///               iff the event satisfies the expression and 0 otherwise.
+  void operator()(event const* xs, size_t n,
+                  std::vector<uint8_t>& result) const;
+
+  /// @returns The tailored expression the checker was compiled from.
+  expression const& expr() const;
+
+  /// @returns `true` iff the checker was compiled from an expression.
+  explicit operator bool() const;
+
+  friend expected<checker> make_checker(expression const& expr, type const& t);
+
+private:
+  expression expr_;
+  std::function<bool(event const&)> check_;
+  std::function<void(event const*, size_t, uint8_t*)> check_batch_;
+};
+
+/// Compiles an expression into a ::checker.
+/// @param expr The expression to compile.
+/// @param t The type of the events to check.
+/// @returns A checker that evaluates *expr* tailored to *t*.
+expected<checker> make_checker(expression const& expr, type const& t);
+
+} // namespace vast
+
+#endif
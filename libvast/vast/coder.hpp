@@ -11,6 +11,7 @@
 #include <caf/meta/save_callback.hpp>
 
 #include "vast/base.hpp"
+#include "vast/bitmap_algorithms.hpp"
 #include "vast/operator.hpp"
 #include "vast/detail/assert.hpp"
 #include "vast/detail/operators.hpp"
@@ -267,10 +268,10 @@ public:
       case not_equal: {
         auto result = this->bitmaps_[x];
         if (x > 0) {
-          auto prev = ~this->bitmaps_[x - 1];
+          auto& prev = this->bitmaps_[x - 1];
           VAST_ASSERT(prev.size() >= result.size());
           result.append_bits(true, prev.size() - result.size());
-          result &= prev;
+          result -= prev;
         }
         result.append_bits(false, this->size_ - result.size());
         if (op == not_equal)
@@ -501,8 +502,12 @@ private:
       --x;
     }
     base_.decompose(x, xs_);
-    bitmap_type result{size(), true};
     auto bitmaps = [&](auto i) -> auto& { return coders[i].storage(); };
+    // Rather than materializing an intermediate result for every component,
+    // we record the operations in a chain and evaluate it in one go.
+    bitmap_type all_ones{size(), true};
+    auto first = static_cast<bitmap_type const*>(&all_ones);
+    bitwise_chain<bitmap_type> chain;
     switch (op) {
       default:
         return bitmap_type{size(), false};
@@ -511,26 +516,32 @@ private:
       case greater:
       case greater_equal: {
         if (xs_[0] < base_[0] - 1) // && bitmap != all_ones
-          result = bitmaps(0)[xs_[0]];
+          first = &bitmaps(0)[xs_[0]];
         for (auto i = 1u; i < base_.size(); ++i) {
           if (xs_[i] != base_[i] - 1) // && bitmap != all_ones
-            result &= bitmaps(i)[xs_[i]];
+            chain.emplace_back(bitwise_and, &bitmaps(i)[xs_[i]]);
           if (xs_[i] != 0) // && bitmap != all_ones
-            result |= bitmaps(i)[xs_[i] - 1];
+            chain.emplace_back(bitwise_or, &bitmaps(i)[xs_[i] - 1]);
         }
       } break;
       case equal:
       case not_equal: {
+        // By the range coding property, the bitmap for value x-1 is a subset
+        // of the bitmap for x. Hence B[x] XOR B[x-1] equals B[x] - B[x-1],
+        // which we can express in a left-deep chain.
         for (auto i = 0u; i < base_.size(); ++i) {
-          if (xs_[i] == 0) // && bitmap != all_ones
-            result &= bitmaps(i)[0];
-          else if (xs_[i] == base_[i] - 1)
-            result &= ~bitmaps(i)[base_[i] - 2];
-          else
-            result &= bitmaps(i)[xs_[i]] ^ bitmaps(i)[xs_[i] - 1];
+          if (xs_[i] == 0) { // && bitmap != all_ones
+            chain.emplace_back(bitwise_and, &bitmaps(i)[0]);
+          } else if (xs_[i] == base_[i] - 1) {
+            chain.emplace_back(minus, &bitmaps(i)[base_[i] - 2]);
+          } else {
+            chain.emplace_back(bitwise_and, &bitmaps(i)[xs_[i]]);
+            chain.emplace_back(minus, &bitmaps(i)[xs_[i] - 1]);
+          }
         }
       } break;
     }
+    auto result = chain_eval(*first, chain);
     if (op == greater || op == greater_equal || op == not_equal)
       result.flip();
     return result;
@@ -547,9 +558,11 @@ private:
   > {
     VAST_ASSERT(op == equal || op == not_equal);
     base_.decompose(x, xs_);
-    auto result = coders[0].decode(equal, xs_[0]);
-    for (auto i = 1u; i < base_.size(); ++i)
-      result &= coders[i].decode(equal, xs_[i]);
+    std::vector<bitmap_type> components;
+    components.reserve(base_.size());
+    for (auto i = 0u; i < base_.size(); ++i)
+      components.push_back(coders[i].decode(equal, xs_[i]));
+    auto result = nary_and(components.begin(), components.end());
     if (op == not_equal || op == not_in)
       result.flip();
     return result;
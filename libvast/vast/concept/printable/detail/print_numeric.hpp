@@ -2,6 +2,7 @@
 #define VAST_CONCEPT_PRINTABLE_DETAIL_PRINT_NUMERIC_HPP
 
 #include <algorithm>
+#include <cstddef>
 #include <limits>
 #include <type_traits>
 
@@ -10,6 +11,37 @@
 namespace vast {
 namespace detail {
 
+// The decimal digits of all numbers from 0 to 99.
+constexpr char decimal_digit_pairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+/// Counts the decimal digits of an unsigned number.
+/// @param x The number to count the digits of.
+/// @returns The number of decimal digits of *x*, which is 1 for 0.
+template <typename T>
+int count_digits(T x) {
+  static_assert(std::is_unsigned<T>{}, "T must be an unsigned type");
+  auto result = 1;
+  for (; x >= 10000; x /= 10000)
+    result += 4;
+  if (x >= 1000)
+    return result + 3;
+  if (x >= 100)
+    return result + 2;
+  if (x >= 10)
+    return result + 1;
+  return result;
+}
+
 template <typename Iterator, typename T>
 bool print_numeric(Iterator& out, T x) {
   static_assert(std::is_integral<T>{}, "T must be an integral type");
@@ -17,13 +49,23 @@ bool print_numeric(Iterator& out, T x) {
     *out++ = '0';
     return true;
   }
+  // We fill the buffer from the back, two digits at a time.
   char buf[std::numeric_limits<T>::digits10 + 1];
-  auto p = buf;
-  while (x > 0) {
-    *p++ = byte_to_char(x % 10);
-    x /= 10;
+  auto p = buf + sizeof(buf);
+  while (x >= 100) {
+    auto i = static_cast<size_t>(x % 100) * 2;
+    x /= 100;
+    *--p = decimal_digit_pairs[i + 1];
+    *--p = decimal_digit_pairs[i];
+  }
+  if (x >= 10) {
+    auto i = static_cast<size_t>(x) * 2;
+    *--p = decimal_digit_pairs[i + 1];
+    *--p = decimal_digit_pairs[i];
+  } else {
+    *--p = byte_to_char(x);
   }
-  out = std::reverse_copy(buf, p, out);
+  out = std::copy(p, buf + sizeof(buf), out);
   return true;
 }
 
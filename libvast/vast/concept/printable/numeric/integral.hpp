@@ -33,8 +33,8 @@ struct integral_printer : printer<integral_printer<T, Policy, MinDigits>> {
   template <typename Iterator, typename U>
   static void pad(Iterator& out, U x) {
     if (MinDigits > 0) {
-      int magnitude = x == 0 ? 0 : std::log10(x < 0 ? -x : x);
-      for (auto i = 1; i < MinDigits - magnitude; ++i)
+      auto digits = detail::count_digits(static_cast<uint64_t>(x));
+      for (auto i = digits; i < MinDigits; ++i)
         *out++ = '0';
     }
   }
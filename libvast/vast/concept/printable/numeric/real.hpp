@@ -17,6 +17,13 @@ struct real_printer : printer<real_printer<T, MaxDigits>> {
 
   using attribute = T;
 
+  static constexpr double scale() {
+    double result = 1;
+    for (auto i = 0; i < MaxDigits; ++i)
+      result *= 10;
+    return result;
+  }
+
   template <typename Iterator>
   bool print(Iterator& out, T x) const {
     // negative = positive + sign
@@ -25,16 +32,16 @@ struct real_printer : printer<real_printer<T, MaxDigits>> {
       x = -x;
     }
     T left;
-    uint64_t right = std::round(std::modf(x, &left) * std::pow(10, MaxDigits));
+    uint64_t right = std::round(std::modf(x, &left) * scale());
     if (MaxDigits == 0)
       return detail::print_numeric(out, static_cast<uint64_t>(std::round(x)));
     if (!detail::print_numeric(out, static_cast<uint64_t>(left)))
       return false;
     *out++ = '.';
     // Add leading decimal zeros.
-    auto magnitude = right == 0 ? MaxDigits : std::log10(right);
-    for (auto i = 1.0; i < MaxDigits - magnitude; ++i)
-      *out++ = '0';
+    if (right > 0)
+      for (auto i = detail::count_digits(right); i < MaxDigits; ++i)
+        *out++ = '0';
     // Avoid trailing zeros on the decimal digits.
     while (right > 0 && right % 10 == 0)
       right /= 10;
@@ -0,0 +1,42 @@
+#ifndef VAST_DETAIL_BLOCK_KERNELS_HPP
+#define VAST_DETAIL_BLOCK_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vast {
+namespace detail {
+
+// Vectorized kernels that operate on contiguous sequences of 64-bit literal
+// blocks, as they occur in uncompressed bitmaps and in the dirty-word runs of
+// EWAH bitmaps. On first use, each kernel selects the widest implementation
+// the CPU supports at runtime (AVX-512, AVX2, or portable scalar code).
+// All binary kernels allow *dst* to alias one of their inputs.
+
+/// Computes `dst[i] = x[i] & y[i]` for all *i* in *[0,n)*.
+void and_blocks(uint64_t* dst, uint64_t const* x, uint64_t const* y,
+                size_t n);
+
+/// Computes `dst[i] = x[i] | y[i]` for all *i* in *[0,n)*.
+void or_blocks(uint64_t* dst, uint64_t const* x, uint64_t const* y,
+               size_t n);
+
+/// Computes `dst[i] = x[i] ^ y[i]` for all *i* in *[0,n)*.
+void xor_blocks(uint64_t* dst, uint64_t const* x, uint64_t const* y,
+                size_t n);
+
+/// Computes `dst[i] = x[i] & ~y[i]` for all *i* in *[0,n)*.
+void and_not_blocks(uint64_t* dst, uint64_t const* x, uint64_t const* y,
+                    size_t n);
+
+/// Computes the total number of 1-bits in *[xs,xs+n)*.
+uint64_t popcount_blocks(uint64_t const* xs, size_t n);
+
+/// Retrieves the name of the instruction set the kernels dispatch to.
+/// @returns One of `"avx512"`, `"avx2"`, or `"scalar"`.
+char const* block_kernels_isa();
+
+} // namespace detail
+} // namespace vast
+
+#endif
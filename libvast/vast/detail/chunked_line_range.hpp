@@ -0,0 +1,67 @@
+#ifndef VAST_DETAIL_CHUNKED_LINE_RANGE_HPP
+#define VAST_DETAIL_CHUNKED_LINE_RANGE_HPP
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vast {
+namespace detail {
+
+// A range of non-empty lines, like ::line_range, but which reads its input in
+// large chunks and locates line breaks with `memchr` (which the C library
+// implements with vector instructions). Besides a copy of the current line,
+// the range exposes a view into the chunk, which remains valid as long as
+// the range advances with `next_buffered`. A chunk holds only as much input
+// as the stream can deliver without blocking, so that lines from pipes and
+// sockets become available as soon as they arrive.
+class chunked_line_range {
+public:
+  using view_type = std::pair<char const*, char const*>;
+
+  static constexpr size_t default_chunk_size = 4 << 20;
+
+  chunked_line_range(std::istream& input,
+                     size_t chunk_size = default_chunk_size);
+
+  std::string const& get() const;
+
+  view_type view() const;
+
+  void next();
+
+  // Advances to the next line only if doing so does not require reading
+  // another chunk from the input, i.e., without invalidating any views.
+  // Returns `false` if that is not possible.
+  bool next_buffered();
+
+  // Checks whether `next` can advance without blocking on the input.
+  bool ready() const;
+
+  bool done() const;
+
+  size_t line_number() const;
+
+private:
+  bool advance(bool refill);
+
+  bool refill();
+
+  std::istream& input_;
+  std::vector<char> chunk_;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+  view_type line_ = {nullptr, nullptr};
+  mutable std::string copy_;
+  mutable bool copied_ = false;
+  size_t line_number_ = 0;
+  bool eof_ = false;
+  bool done_ = false;
+};
+
+} // namespace detail
+} // namespace vast
+
+#endif
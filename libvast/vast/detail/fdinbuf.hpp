@@ -22,6 +22,13 @@ public:
 protected:
   int_type underflow() override;
 
+  // Reports the number of bytes the descriptor can deliver without blocking.
+  std::streamsize showmanyc() override;
+
+  // Reads large requests directly into the destination, bypassing the
+  // buffer, so that bulk reads do not proceed in buffer-sized steps.
+  std::streamsize xsgetn(char_type* s, std::streamsize n) override;
+
 private:
   int fd_;
   std::vector<char> buffer_;
@@ -28,6 +28,10 @@ public:
   /// Returns the size of the mapped memory region.
   size_t size() const;
 
+  /// Returns a pointer to the beginning of the mapped memory region or
+  /// `nullptr` if mapping the file failed.
+  char const* data() const;
+
 protected:
   std::streamsize showmanyc() override;
 
@@ -0,0 +1,75 @@
+#ifndef VAST_EVENT_SLICE_HPP
+#define VAST_EVENT_SLICE_HPP
+
+#include <memory>
+#include <vector>
+
+#include "vast/aliases.hpp"
+#include "vast/event.hpp"
+#include "vast/type.hpp"
+
+namespace caf {
+class serializer;
+class deserializer;
+} // namespace caf
+
+namespace vast {
+
+/// An immutable, reference-counted sequence of events. Copying a slice only
+/// copies a pointer, which allows for passing the same events to several
+/// actors without ever cloning them. A slice also carries the ID range and the
+/// distinct types of its events.
+class event_slice {
+public:
+  using value_type = event;
+  using const_iterator = std::vector<event>::const_iterator;
+  using size_type = std::vector<event>::size_type;
+
+  /// Constructs an empty slice.
+  event_slice() = default;
+
+  /// Constructs a slice from a sequence of events.
+  /// @param xs The events of the slice, which should have contiguous IDs.
+  explicit event_slice(std::vector<event> xs);
+
+  /// Retrieves the ID of the first event.
+  /// @returns The ID of the first event or `invalid_event_id` if empty.
+  event_id first_id() const;
+
+  /// Retrieves the ID one past the last event.
+  /// @returns The ID one past the last event or `invalid_event_id` if empty.
+  event_id last_id() const;
+
+  /// Retrieves the distinct types in the order of first occurrence.
+  std::vector<type> const& types() const;
+
+  /// Retrieves the underlying events.
+  std::vector<event> const& events() const;
+
+  // -- container API ----------------------------------------------------------
+
+  const_iterator begin() const;
+  const_iterator end() const;
+  event const& front() const;
+  event const& back() const;
+  size_type size() const;
+  bool empty() const;
+
+  friend void serialize(caf::serializer& sink, event_slice const& x);
+  friend void serialize(caf::deserializer& source, event_slice& x);
+
+private:
+  struct impl {
+    std::vector<event> events;
+    std::vector<type> types;
+  };
+
+  static std::vector<event> const empty_events;
+  static std::vector<type> const empty_types;
+
+  std::shared_ptr<impl const> ptr_;
+};
+
+} // namespace vast
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef VAST_EWAH_BITMAP_HPP
 #define VAST_EWAH_BITMAP_HPP
 
+#include <vector>
+
 #include "vast/bitmap_base.hpp"
 #include "vast/bitvector.hpp"
 #include "vast/word.hpp"
@@ -149,6 +151,147 @@ private:
 
 ewah_bitmap_range bit_range(ewah_bitmap const& bm);
 
+// -- bitwise operations ------------------------------------------------------
+//
+// These overloads take precedence over the generic algorithms in
+// bitmap_algorithms.hpp. Instead of iterating bit by bit sequence, they walk
+// the run-length encoding of both operands and process runs of dirty words
+// with vectorized block kernels.
+
+ewah_bitmap binary_and(ewah_bitmap const& lhs, ewah_bitmap const& rhs);
+
+ewah_bitmap binary_or(ewah_bitmap const& lhs, ewah_bitmap const& rhs);
+
+ewah_bitmap binary_xor(ewah_bitmap const& lhs, ewah_bitmap const& rhs);
+
+ewah_bitmap binary_nand(ewah_bitmap const& lhs, ewah_bitmap const& rhs);
+
+/// Evaluates a left-deep chain of bitwise operations over EWAH bitmaps in a
+/// single pass. Instead of materializing intermediate results, the algorithm
+/// walks the run-length encodings of all operands simultaneously. A min-heap
+/// over the positions where the current runs end yields the next segment of
+/// words in which every operand is either clean or dirty throughout.
+/// Bits beyond the end of a shorter operand count as 0, and the result has
+/// the size of the longest operand.
+/// @relates chain_eval
+ewah_bitmap chain_eval(ewah_bitmap const& x,
+                       bitwise_chain<ewah_bitmap> const& ys);
+
+/// Computes the conjunction of a sequence of EWAH bitmaps in a single pass.
+/// @relates nary_and
+template <class Iterator>
+ewah_bitmap nary_and(Iterator begin, Iterator end, ewah_bitmap const*) {
+  if (begin == end)
+    return {};
+  bitwise_chain<ewah_bitmap> ys;
+  for (auto i = std::next(begin); i != end; ++i)
+    ys.emplace_back(bitwise_and, &*i);
+  return chain_eval(*begin, ys);
+}
+
+/// Computes the disjunction of a sequence of EWAH bitmaps in a single pass.
+/// @relates nary_or
+template <class Iterator>
+ewah_bitmap nary_or(Iterator begin, Iterator end, ewah_bitmap const*) {
+  if (begin == end)
+    return {};
+  bitwise_chain<ewah_bitmap> ys;
+  for (auto i = std::next(begin); i != end; ++i)
+    ys.emplace_back(bitwise_or, &*i);
+  return chain_eval(*begin, ys);
+}
+
+/// Computes the *rank* of an EWAH bitmap by summing up clean runs and
+/// counting dirty runs with a vectorized population count.
+/// @relates rank
+template <bool Bit = true>
+ewah_bitmap::size_type rank(ewah_bitmap const& bm, ewah_bitmap::size_type i);
+
+/// Computes the position of the *i*-th occurrence of a bit in an EWAH bitmap
+/// by skipping over entire runs.
+/// @relates select ewah_skip_index
+template <bool Bit = true>
+ewah_bitmap::size_type select(ewah_bitmap const& bm, ewah_bitmap::size_type i);
+
+// -- skip index --------------------------------------------------------------
+
+/// A skip index over an EWAH bitmap that answers repeated *rank* and *select*
+/// queries in logarithmic time. The index records the cumulative rank at
+/// sampled word positions, at least *interval* words apart, so that a query
+/// performs a binary search over the samples and then scans at most one
+/// interval of the bitmap.
+///
+/// The index gets built lazily: it only samples the bitmap up to the point
+/// that the queries so far required. Consequently, looking up the first
+/// 1-bit of a large bitmap costs no more than a linear scan would.
+///
+/// The index does not own the bitmap, which must outlive the index and must
+/// not change during its lifetime. The index is not thread-safe.
+class ewah_skip_index {
+public:
+  using size_type = ewah_bitmap::size_type;
+  using word_type = ewah_bitmap::word_type;
+
+  /// The default distance between two samples, in words.
+  static constexpr size_type default_interval = 64;
+
+  /// Constructs a skip index for an EWAH bitmap.
+  /// @param bm The bitmap to index.
+  /// @param interval The minimum number of words between two samples.
+  /// @pre `interval > 0`
+  explicit ewah_skip_index(ewah_bitmap const& bm,
+                           size_type interval = default_interval);
+
+  /// Computes the number of occurrences of a bit in *[0,i]*.
+  /// @param i The position up to where to count.
+  /// @returns The *rank* of the bitmap at position *i*.
+  /// @pre `i < size`
+  template <bool Bit = true>
+  size_type rank(size_type i) const;
+
+  /// Computes the number of occurrences of a bit in the entire bitmap.
+  template <bool Bit = true>
+  size_type rank() const;
+
+  /// Computes the position of the *i*-th occurrence of a bit.
+  /// @param i The occurrence to look for. If `i == npos`, the function
+  ///          returns the position of the last occurrence.
+  /// @returns The position of the *i*-th occurrence of *Bit* or `npos` if
+  ///          the bitmap has less than *i* occurrences.
+  /// @pre `i > 0`
+  template <bool Bit = true>
+  size_type select(size_type i) const;
+
+  /// Finds the next 1-bit after a given position.
+  /// @param i The position after which to start looking. If `i == npos`,
+  ///          the function returns the first 1-bit.
+  /// @returns The position of the next 1-bit or `npos` if none exists.
+  size_type find_next(size_type i) const;
+
+private:
+  // A snapshot of the scan state at a given word position.
+  struct sample {
+    size_type origin; // Block index where the cursor loaded its current run.
+    size_type offset; // Number of words the cursor advanced since then.
+    size_type word;   // Word position in the bitmap.
+    size_type rank;   // Number of 1-bits before *word*.
+  };
+
+  // Continues scanning the bitmap until the frontier satisfies *pred* or
+  // reaches the end of the bitmap.
+  template <class Predicate>
+  void extend(Predicate pred) const;
+
+  // Computes the number of occurrences of *Bit* before a sample.
+  template <bool Bit>
+  size_type count(sample const& x) const;
+
+  ewah_bitmap const* bm_;
+  size_type interval_;
+  mutable std::vector<sample> samples_;
+  mutable sample frontier_;
+};
+
 } // namespace vast
 
 #endif
@@ -0,0 +1,101 @@
+#ifndef VAST_FORMAT_BINARY_HPP
+#define VAST_FORMAT_BINARY_HPP
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "vast/event.hpp"
+#include "vast/expected.hpp"
+#include "vast/schema.hpp"
+#include "vast/type.hpp"
+
+namespace vast {
+namespace format {
+namespace binary {
+
+/// The format of a binary stream of events. A stream consists of a sequence
+/// of frames. Each frame begins with a fixed-size header in network byte
+/// order, consisting of a magic number, the number of events in the frame,
+/// and the size of the payload in bytes. The payload holds the serialized
+/// events. An event consists of a type ID, its own ID, its timestamp, and its
+/// data. The first event of a type also carries the type itself, so that
+/// every type occurs only once per stream.
+constexpr uint32_t magic = 0x56415354; // "VAST"
+constexpr size_t header_size = 16;
+
+/// The maximum payload size of a frame that a reader accepts. Writers emit
+/// frames of about 1 MB by default, so larger sizes indicate a corrupt stream.
+constexpr uint64_t max_frame_size = uint64_t{1} << 30;
+
+/// Writes events in the binary format. The writer serializes events into a
+/// preallocated buffer and emits each frame with a single write.
+class writer {
+public:
+  writer() = default;
+  writer(writer&&) = default;
+  writer& operator=(writer&&) = default;
+
+  /// Constructs a binary writer.
+  /// @param out The stream where to write to.
+  /// @param frame_size The payload size in bytes after which to emit a frame.
+  explicit writer(std::unique_ptr<std::ostream> out,
+                  size_t frame_size = 1 << 20);
+
+  ~writer();
+
+  expected<void> write(event const& e);
+
+  expected<void> flush();
+
+  const char* name() const;
+
+private:
+  // Writes the buffered events as one frame.
+  expected<void> emit();
+
+  std::unique_ptr<std::ostream> out_;
+  size_t frame_size_ = 0;
+  uint32_t events_ = 0;
+  std::vector<char> buffer_;
+  std::unordered_map<type, uint32_t> types_;
+};
+
+/// Reads events in the binary format.
+class reader {
+public:
+  reader() = default;
+
+  /// Constructs a binary reader.
+  /// @param in The stream to read from.
+  explicit reader(std::unique_ptr<std::istream> in);
+
+  expected<event> read();
+
+  expected<void> read(std::vector<event>& xs, size_t max);
+
+  expected<void> schema(vast::schema const& sch);
+
+  expected<vast::schema> schema() const;
+
+  const char* name() const;
+
+private:
+  // Reads and deserializes the next frame.
+  expected<void> next_frame();
+
+  std::unique_ptr<std::istream> in_;
+  std::vector<char> buffer_;
+  std::vector<event> events_;
+  size_t next_ = 0;
+  std::unordered_map<uint32_t, type> types_;
+};
+
+} // namespace binary
+} // namespace format
+} // namespace vast
+
+#endif
@@ -15,9 +15,10 @@
 #include "vast/data.hpp"
 #include "vast/expected.hpp"
 #include "vast/filesystem.hpp"
+#include "vast/offset.hpp"
 #include "vast/schema.hpp"
 
-#include "vast/detail/line_range.hpp"
+#include "vast/detail/chunked_line_range.hpp"
 
 namespace vast {
 
@@ -26,6 +27,14 @@ class event;
 namespace format {
 namespace bro {
 
+/// Unescapes a string from a Bro log, avoiding the copy for the common case of
+/// strings without escape sequences.
+inline std::string bro_unescape(std::string x) {
+  if (x.find('\\') == std::string::npos)
+    return x;
+  return detail::byte_unescape(x);
+}
+
 /// Parses non-container types.
 template <class Iterator, class Attribute>
 struct bro_parser {
@@ -76,13 +85,13 @@ struct bro_parser {
 
   bool operator()(string_type const&) const {
     static auto p = +parsers::any
-      ->* [](std::string x) { return detail::byte_unescape(x); };
+      ->* [](std::string x) { return bro_unescape(std::move(x)); };
     return parse(p);
   }
 
   bool operator()(pattern_type const&) const {
     static auto p = +parsers::any
-      ->* [](std::string x) { return detail::byte_unescape(x); };
+      ->* [](std::string x) { return bro_unescape(std::move(x)); };
     return parse(p);
   }
 
@@ -149,19 +158,19 @@ struct bro_parser_factory {
   result_type operator()(string_type const&) const {
     if (set_separator_.empty())
       return +parsers::any
-        ->* [](std::string x) { return detail::byte_unescape(x); };
+        ->* [](std::string x) { return bro_unescape(std::move(x)); };
     else
       return +(parsers::any - set_separator_)
-               ->*[](std::string x) { return detail::byte_unescape(x); };
+               ->*[](std::string x) { return bro_unescape(std::move(x)); };
   }
 
   result_type operator()(pattern_type const&) const {
     if (set_separator_.empty())
       return +parsers::any
-        ->* [](std::string x) { return detail::byte_unescape(x); };
+        ->* [](std::string x) { return bro_unescape(std::move(x)); };
     else
       return +(parsers::any - set_separator_)
-        ->* [](std::string x) { return detail::byte_unescape(x); };
+        ->* [](std::string x) { return bro_unescape(std::move(x)); };
   }
 
   result_type operator()(address_type const&) const {
@@ -210,17 +219,22 @@ bool bro_basic_parse(type const& t, Iterator& f, Iterator const& l,
   return visit(bro_parser<Iterator, Attribute>{f, l, attr}, t);
 }
 
-/// A Bro reader.
+/// A Bro reader. The reader consumes its input in large chunks and parses
+/// the log lines of a chunk on multiple threads, while preserving their order.
 class reader {
 public:
   reader() = default;
 
   /// Constructs a Bro reader.
   /// @param input The stream of logs to read.
-  explicit reader(std::unique_ptr<std::istream> input);
+  /// @param workers The number of threads that parse lines in parallel. The
+  ///                value 0 selects the number of hardware threads.
+  explicit reader(std::unique_ptr<std::istream> input, size_t workers = 0);
 
   expected<event> read();
 
+  expected<void> read(std::vector<event>& xs, size_t max);
+
   expected<void> schema(vast::schema const& sch);
 
   expected<vast::schema> schema() const;
@@ -228,10 +242,35 @@ public:
   const char* name() const;
 
 private:
+  using iterator_type = char const*;
+
+  // A data line of the current batch.
+  struct line {
+    detail::chunked_line_range::view_type view;
+    size_t number;
+  };
+
   expected<void> parse_header();
 
+  // Reads the next batch of lines and parses them into the buffer.
+  expected<void> fill();
+
+  // Parses the lines of the current batch, potentially in parallel.
+  void parse_batch();
+
+  // Parses a single line into an event.
+  expected<event>
+  parse_line(line const& l,
+             std::vector<std::pair<iterator_type, iterator_type>>& fields)
+  const;
+
   std::unique_ptr<std::istream> input_;
-  std::unique_ptr<detail::line_range> lines_;
+  std::unique_ptr<detail::chunked_line_range> lines_;
+  bool pending_ = false;
+  std::vector<line> batch_;
+  std::vector<expected<event>> buffer_;
+  size_t current_ = 0;
+  size_t workers_ = 1;
   std::string separator_ = " ";
   std::string set_separator_;
   std::string empty_field_;
@@ -240,10 +279,15 @@ private:
   vast::schema schema_;
   type type_;
   record_type record_;
-  std::vector<rule<std::string::const_iterator, data>> parsers_;
+  std::vector<rule<iterator_type, data>> parsers_;
+  std::vector<bool> verbatim_;
+  std::vector<offset> offsets_;
+  vector skeleton_;
 };
 
-/// A Bro writer.
+/// A Bro writer. The writer renders the lines of each log into a buffer and
+/// writes the buffer in large chunks, instead of writing every field
+/// separately.
 class writer {
 public:
   writer() = default;
@@ -252,19 +296,39 @@ public:
 
   /// Constructs a Bro writer.
   /// @param dir The path where to write the log file(s) to.
-  writer(path dir);
+  /// @param workers The number of threads that render a batch of events in
+  ///                parallel. The value 0 selects the number of hardware
+  ///                threads.
+  writer(path dir, size_t workers = 1);
 
   ~writer();
 
   expected<void> write(event const& e);
 
+  /// Writes a batch of events. Large batches are rendered by multiple
+  /// threads, yet the lines of each log appear in the order of the batch.
+  expected<void> write(std::vector<event> const& xs);
+
   expected<void> flush();
 
   const char* name() const;
 
 private:
+  // A log file along with the rendered lines not yet written to it.
+  struct log {
+    std::unique_ptr<std::ostream> out;
+    std::string buffer;
+  };
+
+  // Retrieves the log for a type, creating it on first use.
+  expected<log*> stream(type const& t);
+
+  // Writes the buffered lines of a log.
+  expected<void> emit(log& l);
+
   path dir_;
-  std::unordered_map<std::string, std::unique_ptr<std::ostream>> streams_;
+  size_t workers_ = 1;
+  std::unordered_map<std::string, log> streams_;
 };
 
 } // namespace bro
@@ -4,8 +4,9 @@
 #include <pcap.h>
 
 #include <chrono>
-#include <unordered_map>
+#include <memory>
 #include <random>
+#include <vector>
 
 #include "vast/address.hpp"
 #include "vast/concept/hashable/hash_append.hpp"
@@ -20,6 +21,10 @@ namespace vast {
 
 class event;
 
+namespace detail {
+class mmapbuf;
+} // namespace detail
+
 namespace format {
 namespace pcap {
 
@@ -61,7 +66,81 @@ namespace vast {
 namespace format {
 namespace pcap {
 
-/// A PCAP reader.
+/// A fixed-capacity table of flows. The table uses open addressing with
+/// linear probing over a slot array sized once at construction, and evicts
+/// inactive flows through a timing wheel with one-second ticks, so that
+/// expiration only touches flows that are actually due.
+class flow_table {
+public:
+  /// The per-flow state.
+  struct flow {
+    uint64_t bytes;
+    uint64_t last;
+  };
+
+  flow_table() = default;
+
+  /// Constructs a flow table.
+  /// @param max_flows The maximum number of flows to keep.
+  /// @param max_age The number of seconds of inactivity after which
+  ///                ::expire evicts a flow.
+  flow_table(size_t max_flows, uint64_t max_age);
+
+  /// Retrieves the state of a flow, creating it if it does not exist. If the
+  /// table is full, a new flow replaces a random existing one.
+  /// @param conn The connection identifying the flow.
+  /// @param now The current time in seconds, which becomes the last
+  ///            activity of the flow.
+  /// @returns The state of the flow for *conn*.
+  flow& lookup(connection const& conn, uint64_t now);
+
+  /// Evicts all flows that have been inactive for more than the maximum age.
+  /// @param now The current time in seconds.
+  /// @returns The number of evicted flows.
+  size_t expire(uint64_t now);
+
+  /// @returns The number of flows in the table.
+  size_t size() const;
+
+private:
+  struct slot {
+    connection conn;
+    size_t hash;
+    uint64_t deadline;
+    flow state;
+    bool occupied = false;
+  };
+
+  struct timer {
+    connection conn;
+    uint64_t deadline;
+  };
+
+  size_t find(connection const& conn, size_t hash) const;
+
+  void erase(size_t i);
+
+  void schedule(slot& x);
+
+  std::vector<slot> slots_;
+  size_t mask_ = 0;
+  size_t size_ = 0;
+  size_t max_flows_ = 0;
+  uint64_t max_age_ = 0;
+  std::vector<std::vector<timer>> wheel_;
+  std::vector<timer> due_;
+  uint64_t wheel_time_ = 0;
+  std::mt19937 generator_;
+};
+
+/// A PCAP reader. When reading from a trace file, the reader maps the file
+/// into memory and parses the record headers directly, falling back to
+/// libpcap for interfaces, standard input, and traces it cannot parse.
+///
+/// The reader can split the flows into multiple shards by hashing their
+/// connection. Each shard has its own flow table and cutoff state, and
+/// batched reads turn the packets of each shard into events on a separate
+/// thread.
 class reader {
 public:
   reader() = default;
@@ -77,15 +156,23 @@ public:
   /// @param pseudo_realtime The inverse factor by which to delay packets. For
   ///                        example, if 5, then for two packets spaced *t*
   ///                        seconds apart, the source will sleep for *t/5*
-  ///                        seconds.
+  ///                        seconds. Only available with a single shard.
+  /// @param shards The number of shards to distribute flows over.
   explicit reader(std::string input, uint64_t cutoff = -1,
                   size_t max_flows = 100000, size_t max_age = 60,
-                  size_t expire_interval = 10, int64_t pseudo_realtime = 0);
+                  size_t expire_interval = 10, int64_t pseudo_realtime = 0,
+                  size_t shards = 1);
 
   ~reader();
 
+  reader(reader&&);
+
+  reader& operator=(reader&&);
+
   expected<event> read();
 
+  expected<void> read(std::vector<event>& xs, size_t max);
+
   expected<void> schema(vast::schema const& sch);
 
   expected<vast::schema> schema() const;
@@ -93,20 +180,59 @@ public:
   const char* name() const;
 
 private:
-  struct connection_state {
-    uint64_t bytes;
-    uint64_t last;
+  // A captured packet.
+  struct packet {
+    uint64_t secs;
+    uint64_t nsecs;
+    uint32_t caplen;
+    uint32_t len;
+    uint8_t const* data;
   };
 
+  // The result of parsing the headers of a packet.
+  struct dissection {
+    connection conn;
+    uint64_t payload_size;
+  };
+
+  // The flow state for a subset of the connections.
+  struct shard {
+    flow_table flows;
+    uint64_t last_expire;
+  };
+
+  expected<void> open();
+
+  // Attempts to map the input as trace file.
+  bool map_trace();
+
+  // Fetches the next packet, returning no error if none is available yet.
+  expected<packet> next();
+
+  // Parses the headers of a packet, returning no error for non-IP packets.
+  expected<dissection> dissect(packet const& p) const;
+
+  // Applies the flow cutoff and creates an event from a packet.
+  expected<event> process(shard& s, packet const& p,
+                          dissection const& d) const;
+
+  // Dissects and processes a packet, pacing it in pseudo-realtime mode.
+  // Returns no error if the packet yields no event.
+  expected<event> make_event(packet const& p);
+
+  expected<void> read_sharded(std::vector<event>& xs, size_t max);
+
   pcap_t* pcap_ = nullptr;
+  std::unique_ptr<detail::mmapbuf> trace_;
+  size_t trace_offset_ = 0;
+  bool trace_swapped_ = false;
+  bool trace_nanoseconds_ = false;
   type packet_type_;
-  std::unordered_map<connection, connection_state> flows_;
+  std::vector<shard> shards_;
   uint64_t cutoff_;
   size_t max_flows_;
-  std::mt19937 generator_;
   uint64_t max_age_;
   uint64_t expire_interval_;
-  uint64_t last_expire_ = 0;
   timestamp last_timestamp_ = timestamp::min();
   int64_t pseudo_realtime_;
   std::string input_;
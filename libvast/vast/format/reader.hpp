@@ -3,12 +3,14 @@
 
 #include <istream>
 #include <memory>
+#include <vector>
 
 #include "vast/detail/assert.hpp"
 #include "vast/detail/line_range.hpp"
 #include "vast/error.hpp"
 #include "vast/event.hpp"
 #include "vast/expected.hpp"
+#include "vast/logger.hpp"
 
 namespace vast {
 namespace format {
@@ -36,6 +38,21 @@ public:
     return e;
   }
 
+  expected<void> read(std::vector<event>& xs, size_t max) {
+    for (size_t produced = 0; produced < max; lines_->next()) {
+      if (lines_->done())
+        return make_error(ec::end_of_input, "input exhausted");
+      event e;
+      if (!parser_(lines_->get(), e)) {
+        VAST_WARNING("reader ignores unparsable line", lines_->line_number());
+        continue;
+      }
+      xs.push_back(std::move(e));
+      ++produced;
+    }
+    return no_error;
+  }
+
 protected:
   Parser parser_;
 
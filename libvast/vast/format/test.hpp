@@ -54,6 +54,8 @@ public:
 
   expected<event> read();
 
+  expected<void> read(std::vector<event>& xs, size_t max);
+
   expected<void> schema(vast::schema sch);
 
   expected<vast::schema> schema() const;
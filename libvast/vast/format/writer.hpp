@@ -1,9 +1,14 @@
 #ifndef VAST_FORMAT_WRITER_HPP
 #define VAST_FORMAT_WRITER_HPP
 
+#include <algorithm>
+#include <future>
 #include <iterator>
 #include <memory>
 #include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "vast/error.hpp"
 #include "vast/event.hpp"
@@ -12,26 +17,124 @@
 namespace vast {
 namespace format {
 
-/// A generic event writer.
+/// A generic event writer. The writer renders events into a contiguous
+/// buffer and hands it to the output stream in large chunks, instead of
+/// pushing every character through the stream. Large batches of events are
+/// rendered by multiple threads, each of which prints a contiguous slice of
+/// the batch into its own buffer. Since the writer appends the buffers in
+/// order, the output is the same as with a single thread.
 template <class Printer>
 class writer {
 public:
+  /// The number of buffered bytes after which the writer emits the buffer.
+  static constexpr size_t buffer_size = 64 << 10;
+
+  /// The minimum number of events per rendering thread.
+  static constexpr size_t min_events_per_worker = 1024;
+
   writer() = default;
+  writer(writer&&) = default;
+  writer& operator=(writer&&) = default;
 
   /// Constructs a generic writer.
   /// @param out The stream where to write to
-  explicit writer(std::unique_ptr<std::ostream> out) : out_{std::move(out)} {
+  /// @param workers The number of threads that render a batch of events in
+  ///                parallel. The value 0 selects the number of hardware
+  ///                threads.
+  explicit writer(std::unique_ptr<std::ostream> out, size_t workers = 1)
+    : out_{std::move(out)},
+      workers_{workers > 0 ? workers : std::thread::hardware_concurrency()} {
+    buffer_.reserve(buffer_size + (buffer_size >> 2));
+    if (workers_ == 0)
+      workers_ = 1;
+  }
+
+  ~writer() {
+    if (out_)
+      emit();
   }
 
   expected<void> write(event const& e) {
-    auto i = std::ostreambuf_iterator<char>(*out_);
-    if (!printer_.print(i, e))
+    auto size = buffer_.size();
+    auto i = std::back_inserter(buffer_);
+    if (!printer_.print(i, e)) {
+      buffer_.resize(size);
       return make_error(ec::print_error, "failed to print event:", e);
-    *out_ << '\n';
+    }
+    buffer_ += '\n';
+    if (buffer_.size() >= buffer_size)
+      return emit();
+    return {};
+  }
+
+  expected<void> write(std::vector<event> const& xs) {
+    auto n = xs.size();
+    auto workers = std::max(size_t{1},
+                            std::min(workers_, n / min_events_per_worker));
+    if (workers == 1) {
+      for (auto& x : xs) {
+        auto r = write(x);
+        if (!r)
+          return r;
+      }
+      return {};
+    }
+    // Every worker prints with its own copy of the printer. To give stateful
+    // printers, such as the CSV printer tracking the current header, the same
+    // view as in sequential rendering, a worker first renders the event
+    // preceding its slice into a scratch buffer.
+    std::vector<Printer> printers(workers, printer_);
+    std::vector<std::string> buffers(workers);
+    std::vector<size_t> failed(workers, n);
+    auto work = [&](size_t i) {
+      auto first = n * i / workers;
+      auto last = n * (i + 1) / workers;
+      auto& printer = printers[i];
+      auto& buf = buffers[i];
+      if (i > 0) {
+        auto out = std::back_inserter(buf);
+        printer.print(out, xs[first - 1]);
+        buf.clear();
+      }
+      for (auto j = first; j < last; ++j) {
+        auto size = buf.size();
+        auto out = std::back_inserter(buf);
+        if (!printer.print(out, xs[j])) {
+          buf.resize(size);
+          failed[i] = j;
+          return;
+        }
+        buf += '\n';
+      }
+    };
+    std::vector<std::future<void>> futures;
+    for (auto i = 1u; i < workers; ++i)
+      futures.push_back(std::async(std::launch::async, work, i));
+    work(0);
+    for (auto& f : futures)
+      f.get();
+    // Append the buffers in order, stopping after the first failed event.
+    for (auto i = 0u; i < workers; ++i) {
+      buffer_ += buffers[i];
+      if (failed[i] != n) {
+        printer_ = std::move(printers[i]);
+        return make_error(ec::print_error, "failed to print event:",
+                          xs[failed[i]]);
+      }
+      if (buffer_.size() >= buffer_size) {
+        auto r = emit();
+        if (!r)
+          return r;
+      }
+    }
+    printer_ = std::move(printers.back());
     return {};
   }
 
   expected<void> flush() {
+    auto r = emit();
+    if (!r)
+      return r;
     out_->flush();
     if (!*out_)
       return make_error(ec::format_error, "failed to flush");
@@ -39,7 +142,19 @@ public:
   }
 
 private:
+  expected<void> emit() {
+    if (buffer_.empty())
+      return {};
+    out_->write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+    if (!*out_)
+      return make_error(ec::format_error, "failed to write");
+    return {};
+  }
+
   std::unique_ptr<std::ostream> out_;
+  size_t workers_ = 1;
+  std::string buffer_;
   Printer printer_;
 };
 
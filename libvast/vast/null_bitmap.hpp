@@ -7,8 +7,15 @@
 
 namespace vast {
 
+class null_bitmap;
 class null_bitmap_range;
 
+/// Computes the *rank* of an uncompressed bitmap with a vectorized population
+/// count over its blocks.
+/// @relates rank
+template <bool Bit = true>
+uint64_t rank(null_bitmap const& bm, uint64_t i);
+
 /// An uncompressed bitmap. Essentially, a null_bitmap lifts an append-only
 /// ::bitvector into a bitmap type, enabling efficient block-level operations
 /// and making it compatiable with algorithms that operate on bitmaps.
@@ -50,6 +57,14 @@ public:
 
   friend null_bitmap_range bit_range(null_bitmap const& bm);
 
+  friend null_bitmap binary_and(null_bitmap const& x, null_bitmap const& y);
+  friend null_bitmap binary_or(null_bitmap const& x, null_bitmap const& y);
+  friend null_bitmap binary_xor(null_bitmap const& x, null_bitmap const& y);
+  friend null_bitmap binary_nand(null_bitmap const& x, null_bitmap const& y);
+
+  template <bool Bit>
+  friend uint64_t rank(null_bitmap const& bm, uint64_t i);
+
 private:
   bitvector_type bitvector_;
 };
@@ -72,6 +87,19 @@ private:
   typename null_bitmap::bitvector_type::block_vector::const_iterator end_;
 };
 
+// -- bitwise operations ------------------------------------------------------
+//
+// These overloads take precedence over the generic algorithms in
+// bitmap_algorithms.hpp and process entire block sequences with vectorized
+// block kernels.
+
+null_bitmap binary_and(null_bitmap const& lhs, null_bitmap const& rhs);
+
+null_bitmap binary_or(null_bitmap const& lhs, null_bitmap const& rhs);
+
+null_bitmap binary_xor(null_bitmap const& lhs, null_bitmap const& rhs);
+
+null_bitmap binary_nand(null_bitmap const& lhs, null_bitmap const& rhs);
 
 } // namespace vast
 
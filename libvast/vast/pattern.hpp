@@ -43,6 +43,10 @@ public:
   /// @returns `true` if the pattern matches inside *str*.
   bool search(std::string const& str) const;
 
+  /// Retrieves the regular expression of the pattern.
+  /// @returns The string representation of the pattern.
+  std::string const& string() const;
+
   friend bool operator==(pattern const& lhs, pattern const& rhs);
   friend bool operator<(pattern const& lhs, pattern const& rhs);
 
@@ -0,0 +1,57 @@
+#ifndef VAST_PROJECTION_HPP
+#define VAST_PROJECTION_HPP
+
+#include <unordered_map>
+#include <vector>
+
+#include "vast/event.hpp"
+#include "vast/key.hpp"
+#include "vast/offset.hpp"
+#include "vast/optional.hpp"
+#include "vast/type.hpp"
+
+namespace vast {
+
+/// Projects events onto a subset of their fields. A key selects all fields
+/// whose name ends in the key, just like a key extractor in a query. The
+/// projected event has a flat record type with one field per selected field,
+/// named by its full key within the original record. The projection computes
+/// the resulting layout once per event type and then merely copies the
+/// selected values.
+class projection {
+public:
+  /// Constructs an empty projection, which leaves events unchanged.
+  projection() = default;
+
+  /// Constructs a projection from a list of keys.
+  /// @param keys The keys of the fields to select.
+  explicit projection(std::vector<key> keys);
+
+  /// Projects an event.
+  /// @param e The event to project.
+  /// @returns The projected event with the ID and timestamp of *e*, *e* itself
+  ///          if the projection is empty or *e* does not have a record type,
+  ///          and nothing if no field of *e* matches a key.
+  optional<event> operator()(event const& e);
+
+  /// @returns The keys of the projection.
+  std::vector<key> const& keys() const;
+
+  /// @returns `true` iff the projection has no keys.
+  bool empty() const;
+
+private:
+  struct layout {
+    type projected;
+    std::vector<offset> offsets;
+  };
+
+  layout const& make_layout(record_type const& r, type const& t);
+
+  std::vector<key> keys_;
+  std::unordered_map<type, layout> layouts_;
+};
+
+} // namespace vast
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef VAST_QUERY_MATCHER_HPP
+#define VAST_QUERY_MATCHER_HPP
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "vast/data.hpp"
+#include "vast/expression.hpp"
+#include "vast/type.hpp"
+
+namespace vast {
+
+class event;
+
+/// Matches events against a set of standing queries. Rather than evaluating
+/// each query separately, the matcher compiles all queries for a given event
+/// type into one set of distinct predicates. Equality predicates and
+/// membership tests against constant sets live in hash tables keyed by value,
+/// so finding the satisfied predicates of an event costs one lookup per
+/// extractor instead of one evaluation per query. A conjunctive query matches
+/// when the number of its satisfied predicates equals its size; all other
+/// queries run a small boolean program over the satisfied predicates, but only
+/// when at least one of their predicates holds.
+class query_matcher {
+public:
+  using query_id = uint64_t;
+
+  /// Registers a standing query.
+  /// @param id The ID of the query.
+  /// @param expr The normalized and validated query expression.
+  /// @returns `true` iff no query with ID *id* existed.
+  bool add(query_id id, expression expr);
+
+  /// Removes a standing query.
+  /// @param id The ID of the query.
+  /// @returns `true` iff a query with ID *id* existed.
+  bool remove(query_id id);
+
+  /// Matches an event against all queries.
+  /// @param e The event to match.
+  /// @param result The vector to append the IDs of all matching queries to.
+  void match(event const& e, std::vector<query_id>& result);
+
+  /// @returns The number of registered queries.
+  size_t size() const;
+
+  /// @returns `true` iff no query is registered.
+  bool empty() const;
+
+private:
+  // An instruction of a query compiled into postfix notation.
+  struct instruction {
+    enum opcode : uint8_t { load, all, any, negate };
+    opcode op;
+    uint32_t arg; // The predicate for `load`, else the number of operands.
+  };
+
+  struct program {
+    query_id id;
+    std::vector<instruction> code;
+    std::vector<uint32_t> distinct; // The distinct predicates.
+    uint32_t predicates; // The number of distinct predicates.
+    bool conjunctive;    // Whether the query holds iff all predicates hold.
+  };
+
+  struct data_hash {
+    size_t operator()(data const& x) const;
+  };
+
+  // Maps the values of one extractor to the predicates they satisfy.
+  struct value_index {
+    predicate::operand extractor;
+    std::unordered_map<data, std::vector<uint32_t>, data_hash> values;
+  };
+
+  // All queries tailored to a single type. Adding a query extends the
+  // compiled type in place. Removing one leaves its predicates behind until
+  // they make up half of all predicates, at which point we recompile.
+  struct compiled_type {
+    std::unordered_map<predicate, uint32_t> ids;
+    std::vector<predicate> predicates;
+    std::vector<value_index> indexes;
+    std::vector<std::pair<predicate, uint32_t>> scanned;
+    std::vector<std::vector<uint32_t>> subscribers;
+    std::vector<program> programs;
+    std::vector<uint32_t> always;
+    size_t unused = 0; // The number of predicates without subscribers.
+  };
+
+  struct compiler;
+
+  compiled_type& compile(type const& t);
+
+  // Adds a query to a compiled type, if the query applies to the type.
+  void attach(compiled_type& ct, type const& t, query_id id,
+              expression const& expr);
+
+  // Removes a query from a compiled type.
+  // @returns `false` iff the compiled type should be recompiled.
+  bool detach(compiled_type& ct, query_id id);
+
+  bool run(program const& p);
+
+  std::map<query_id, expression> queries_;
+  std::unordered_map<type, compiled_type> types_;
+  std::vector<bool> satisfied_;
+  std::vector<uint32_t> counts_;
+  std::vector<uint32_t> hits_;
+  std::vector<uint32_t> touched_;
+  std::vector<bool> stack_;
+};
+
+} // namespace vast
+
+#endif
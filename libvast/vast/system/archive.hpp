@@ -12,6 +12,7 @@
 #include "vast/detail/range_map.hpp"
 #include "vast/die.hpp"
 #include "vast/event.hpp"
+#include "vast/event_slice.hpp"
 #include "vast/filesystem.hpp"
 #include "vast/uuid.hpp"
 #include "vast/compression.hpp"
@@ -35,6 +36,10 @@ public:
 
   expected<std::vector<event>> extract(bitmap const& bm) const;
 
+  /// Extracts the events whose IDs occur in an indexed bitmap. Callers that
+  /// extract from multiple segments can share the index between them.
+  expected<std::vector<event>> extract(bitmap_skip_index const& ids) const;
+
   uuid const& id() const;
 
   template <class Inspector>
@@ -63,7 +68,7 @@ struct archive_state {
 };
 
 using archive_type = caf::typed_actor<
-  caf::reacts_to<std::vector<event>>,
+  caf::replies_to<event_slice>::with<ok_atom>,
   caf::replies_to<flush_atom>::with<ok_atom>,
   caf::replies_to<bitmap>::with<std::vector<event>>
 >;
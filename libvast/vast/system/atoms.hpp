@@ -24,7 +24,9 @@ using accept_atom = caf::atom_constant<caf::atom("accept")>;
 using announce_atom = caf::atom_constant<caf::atom("announce")>;
 using batch_atom = caf::atom_constant<caf::atom("batch")>;
 using continuous_atom = caf::atom_constant<caf::atom("continuous")>;
+using count_atom = caf::atom_constant<caf::atom("count")>;
 using cpu_atom = caf::atom_constant<caf::atom("cpu")>;
+using credit_atom = caf::atom_constant<caf::atom("credit")>;
 using data_atom = caf::atom_constant<caf::atom("data")>;
 using disable_atom = caf::atom_constant<caf::atom("disable")>;
 using disconnect_atom = caf::atom_constant<caf::atom("disconnect")>;
@@ -34,6 +36,7 @@ using empty_atom = caf::atom_constant<caf::atom("empty")>;
 using enable_atom = caf::atom_constant<caf::atom("enable")>;
 using exists_atom = caf::atom_constant<caf::atom("exists")>;
 using extract_atom = caf::atom_constant<caf::atom("extract")>;
+using group_atom = caf::atom_constant<caf::atom("group")>;
 using heartbeat_atom = caf::atom_constant<caf::atom("heartbeat")>;
 using heap_atom = caf::atom_constant<caf::atom("heap")>;
 using historical_atom = caf::atom_constant<caf::atom("historical")>;
@@ -48,6 +51,7 @@ using persist_atom = caf::atom_constant<caf::atom("persist")>;
 using ping_atom = caf::atom_constant<caf::atom("ping")>;
 using pong_atom = caf::atom_constant<caf::atom("pong")>;
 using progress_atom = caf::atom_constant<caf::atom("progress")>;
+using project_atom = caf::atom_constant<caf::atom("project")>;
 using prompt_atom = caf::atom_constant<caf::atom("prompt")>;
 using publish_atom = caf::atom_constant<caf::atom("publish")>;
 using query_atom = caf::atom_constant<caf::atom("query")>;
@@ -77,6 +81,7 @@ using accountant_atom = caf::atom_constant<caf::atom("accountant")>;
 using candidate_atom = caf::atom_constant<caf::atom("candidate")>;
 using consensus_atom = caf::atom_constant<caf::atom("consensus")>;
 using identifier_atom = caf::atom_constant<caf::atom("identifier")>;
+using matcher_atom = caf::atom_constant<caf::atom("matcher")>;
 using index_atom = caf::atom_constant<caf::atom("index")>;
 using follower_atom = caf::atom_constant<caf::atom("follower")>;
 using leader_atom = caf::atom_constant<caf::atom("leader")>;
@@ -4,16 +4,20 @@
 #include <chrono>
 #include <deque>
 #include <memory>
+#include <string>
 #include <unordered_map>
 
 #include "vast/aliases.hpp"
 #include "vast/bitmap.hpp"
+#include "vast/checker.hpp"
 #include "vast/expression.hpp"
+#include "vast/projection.hpp"
 #include "vast/query_options.hpp"
 #include "vast/uuid.hpp"
 
 #include "vast/system/accountant.hpp"
 #include "vast/system/archive.hpp"
+#include "vast/system/partition.hpp"
 #include "vast/system/query_statistics.hpp"
 
 namespace vast {
@@ -25,19 +29,48 @@ struct exporter_state {
   caf::actor sink;
   accountant_type accountant;
   bitmap hits;
+  bitmap pending;
   bitmap unprocessed;
-  std::unordered_map<type, expression> checkers;
+  std::unordered_map<type, checker> checkers;
   std::deque<event> candidates;
   std::vector<event> results;
   std::chrono::steady_clock::time_point start;
   query_statistics stats;
+  query_options options;
+  uint64_t limit = 0;
+  bool aggregate = false;
+  bool verify = false;
+  uint64_t matched = 0;
+  std::string group;
+  group_counts counts;
+  projection project;
   uuid id;
   char const* name = "exporter";
 };
 
 /// The EXPORTER receives index hits, looks up the corresponding events in the
 /// archive, and performs a candidate check to select the resulting stream of
-/// matching events.
+/// matching events. Continuous EXPORTERs additionally subscribe their query at
+/// the STREAM MATCHERs and relay the matches among newly imported events.
+///
+/// The EXPORTER only takes as many index hits to the ARCHIVE as it needs to
+/// satisfy the outstanding extraction requests and keeps the remainder for
+/// later. With a limit, set via `limit_atom`, the EXPORTER cancels the lookup
+/// at the INDEX and terminates as soon as it has shipped enough results.
+///
+/// After receiving `count_atom`, the EXPORTER answers an aggregate query
+/// without fetching any events from the ARCHIVE. A plain count sums up the
+/// index hits. With a group key, the EXPORTER sums up the ::group_counts of
+/// all partitions instead. Either way, it ships the counts as events of type
+/// `vast::count` or `vast::group` once all partitions have answered. This
+/// shortcut requires that the index answers every predicate exactly. If the
+/// expression involves binned values such as times or reals, the EXPORTER
+/// counts the results of the candidate check instead, provided it has an
+/// ARCHIVE. Without one, such counts are upper bounds.
+///
+/// After receiving `project_atom` with a list of keys, the EXPORTER projects
+/// all results onto the corresponding fields before shipping them. Sinks then
+/// render only the selected columns.
 /// @param self The actor handle.
 /// @param ast The AST of query.
 /// @param qos The query options.
@@ -2,13 +2,16 @@
 #define VAST_SYSTEM_IMPORTER_HPP
 
 #include <chrono>
+#include <deque>
 #include <vector>
 
+#include <caf/response_promise.hpp>
 #include <caf/stateful_actor.hpp>
 
 #include "vast/aliases.hpp"
 #include "vast/data.hpp"
 #include "vast/event.hpp"
+#include "vast/event_slice.hpp"
 #include "vast/filesystem.hpp"
 
 #include "vast/system/archive.hpp"
@@ -18,16 +21,32 @@ namespace vast {
 namespace system {
 
 /// Receives chunks from SOURCEs, imbues them with an ID, and relays them to
-/// ARCHIVE and INDEX.
+/// ARCHIVE and INDEX. Each chunk gets acknowledged with an `ok_atom` after
+/// both ARCHIVE and INDEX have processed it. In addition, the IMPORTER tees
+/// each chunk to the STREAM MATCHERs for continuous queries.
 struct importer_state {
+  /// A batch waiting for IDs along with the promise to acknowledge it.
+  struct pending_batch {
+    std::vector<event> events;
+    caf::response_promise promise;
+  };
   meta_store_type meta_store;
   caf::actor archive;
   caf::actor index;
+  caf::actor matcher;
+  /// The next ID of the current lease.
   event_id next = 0;
+  /// The number of IDs left in the current lease.
   event_id available = 0;
+  /// The first ID of the lease fetched ahead of time.
+  event_id prefetched_next = 0;
+  /// The number of IDs in the lease fetched ahead of time.
+  event_id prefetched = 0;
+  /// Whether a lease request to the meta store is outstanding.
+  bool leasing = false;
   size_t batch_size;
   std::chrono::steady_clock::time_point last_replenish;
-  std::vector<event> remainder;
+  std::deque<pending_batch> backlog;
   path dir;
   const char* name = "importer";
 };
@@ -35,7 +54,7 @@ struct importer_state {
 /// Spawns an IMPORTER.
 /// @param self The actor handle.
 /// @param dir The directory for persistent state.
-/// @param batch_size The initial number of IDs to request when replenishing.
+/// @param batch_size The initial number of IDs to lease at once.
 caf::behavior importer(caf::stateful_actor<importer_state>* self,
                        path dir, size_t batch_size);
 
@@ -1,13 +1,16 @@
 #ifndef VAST_INDEX_HPP
 #define VAST_INDEX_HPP
 
+#include <string>
 #include <unordered_map>
 
 #include <caf/stateful_actor.hpp>
 
 #include "vast/bitmap.hpp"
+#include "vast/event_slice.hpp"
 #include "vast/expression.hpp"
 #include "vast/filesystem.hpp"
+#include "vast/query_options.hpp"
 #include "vast/uuid.hpp"
 #include "vast/time.hpp"
 
@@ -34,9 +37,12 @@ public:
   };
 
   /// Adds a set of events to the index for a given partition.
-  void add(const std::vector<event> xs, const uuid& partition);
+  void add(const event_slice& xs, const uuid& partition);
 
   /// Retrieves the list of partition IDs for a given expression.
+  /// @param expr The expression to look up.
+  /// @returns The IDs of all qualifying partitions, ordered from the oldest
+  ///          to the most recent one by the end of their time interval.
   std::vector<uuid> lookup(const expression& expr) const;
 
   template <class Inspector>
@@ -71,11 +77,22 @@ struct scheduled_partition_state {
 
 struct lookup_state {
   expression expr;
+  std::string group; ///< The key to count hits by, if non-empty.
   caf::actor sink;
   std::vector<uuid> partitions;
 };
 
 struct index_state {
+  using magic_type = uint32_t;
+  using version_type = uint32_t;
+
+  static constexpr magic_type magic = 0x1d1d1d1d;
+
+  /// The on-disk format version of the index and its partitions. Version 2
+  /// persists timestamp columns as ::timestamp_index instead of an
+  /// arithmetic index, so older databases must be re-imported.
+  static constexpr version_type version = 2;
+
   partition_index part_index;
   active_partition_state active;
   std::unordered_map<uuid, caf::actor> loaded;
@@ -87,7 +104,11 @@ struct index_state {
   char const* name = "index";
 };
 
-/// Indexes events in horizontal partitions.
+/// Indexes events in horizontal partitions. A lookup consists of an
+/// expression and optional ::query_options, which determine whether the INDEX
+/// schedules the most recent (default) or the oldest partitions first.
+/// Aggregate lookups additionally carry `group_atom` and a key, in which case
+/// the partitions respond with ::group_counts instead of bitmaps.
 /// @param dir The directory of the index.
 /// @param max_events The maximum number of events per partition.
 /// @param max_parts The maximum number of partitions to hold in memory.
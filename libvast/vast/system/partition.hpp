@@ -1,6 +1,9 @@
 #ifndef VAST_SYSTEM_PARTITION_HPP
 #define VAST_SYSTEM_PARTITION_HPP
 
+#include <cstdint>
+#include <map>
+#include <string>
 #include <unordered_map>
 
 #include <caf/stateful_actor.hpp>
@@ -12,6 +15,9 @@
 namespace vast {
 namespace system {
 
+/// The number of hits per group of an aggregate query.
+using group_counts = std::map<std::string, uint64_t>;
+
 struct partition_state {
   std::unordered_map<type, caf::actor> indexers;
   const char* name = "partition";
@@ -20,6 +26,12 @@ struct partition_state {
 /// A horizontal partition of the INDEX.
 /// For each event batch, PARTITION spawns one event indexer per
 /// type occurring in the batch and forwards to them the events.
+///
+/// Besides answering an expression with a bitmap of hits, PARTITION counts
+/// hits per group for an expression along with `group_atom` and a key. The
+/// key `&type` groups by event type, any other key groups by the values `T`
+/// and `F` of a boolean field. PARTITION answers the derived expression of
+/// each group from its indexes and responds with ::group_counts.
 /// @param dir The directory where to store this partition on the file system.
 caf::behavior partition(caf::stateful_actor<partition_state>* self, path dir);
 
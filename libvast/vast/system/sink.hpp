@@ -1,8 +1,11 @@
 #ifndef VAST_SYSTEM_SINK_HPP
 #define VAST_SYSTEM_SINK_HPP
 
+#include <algorithm>
 #include <cstdint>
 #include <chrono>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "vast/logger.hpp"
@@ -26,17 +29,53 @@ struct Writer {
 
   expected<void> write(event const&);
 
+  // Optional: writes a batch of events at once.
+  expected<void> write(std::vector<event> const&);
+
   expected<void> flush();
 
   char const* name() const;
 };
 #endif
 
+/// Checks whether a *Writer* can write a batch of events at once.
+template <class Writer, class = void>
+struct has_batch_write : std::false_type {};
+
+template <class Writer>
+struct has_batch_write<
+  Writer,
+  decltype(void(std::declval<Writer&>().write(
+    std::declval<std::vector<event> const&>())))
+> : std::true_type {};
+
+// Writes the first *n* events of a batch.
+template <class Writer>
+std::enable_if_t<has_batch_write<Writer>::value, expected<void>>
+write_batch(Writer& writer, std::vector<event> const& xs, size_t n) {
+  if (n == xs.size())
+    return writer.write(xs);
+  return writer.write(std::vector<event>(xs.begin(), xs.begin() + n));
+}
+
+template <class Writer>
+std::enable_if_t<!has_batch_write<Writer>::value, expected<void>>
+write_batch(Writer& writer, std::vector<event> const& xs, size_t n) {
+  for (auto i = 0u; i < n; ++i) {
+    auto r = writer.write(xs[i]);
+    if (!r)
+      return r;
+  }
+  return {};
+}
+
 // The base class for SINK actors.
 template <class Writer>
 struct sink_state {
   std::chrono::steady_clock::duration flush_interval = std::chrono::seconds(1);
   std::chrono::steady_clock::time_point last_flush;
+  bool dirty = false;
+  bool flush_scheduled = false;
   uint64_t processed = 0;
   uint64_t limit = 0;
   Writer writer;
@@ -52,25 +91,48 @@ sink(caf::stateful_actor<sink_state<Writer>>* self, Writer&& writer) {
   self->state.last_flush = steady_clock::now();
   return {
     [=](const std::vector<event>& xs) {
-      for (auto& x : xs) {
-        auto r = self->state.writer.write(x);
-        if (!r) {
-          VAST_ERROR(self->system().render(r.error()));
-          self->quit(r.error());
-          return;
-        }
-        if (++self->state.processed == self->state.limit) {
-          VAST_INFO(self, "reached limit:", self->state.limit, "events");
-          self->quit();
-          return;
-        }
-        auto now = steady_clock::now();
-        if (now - self->state.last_flush > self->state.flush_interval) {
-          self->state.writer.flush();
-          self->state.last_flush = now;
+      auto n = xs.size();
+      if (self->state.limit > 0)
+        n = std::min(n, static_cast<size_t>(self->state.limit
+                                            - self->state.processed));
+      auto r = write_batch(self->state.writer, xs, n);
+      if (!r) {
+        VAST_ERROR(self->system().render(r.error()));
+        self->quit(r.error());
+        return;
+      }
+      self->state.processed += n;
+      if (self->state.processed == self->state.limit) {
+        VAST_INFO(self, "reached limit:", self->state.limit, "events");
+        self->state.writer.flush();
+        self->quit();
+        return;
+      }
+      // Writers buffer their output, so we check only once per batch whether
+      // it's time to flush. Otherwise we schedule a flush, so that the output
+      // does not linger in the buffer when no further batch arrives.
+      auto now = steady_clock::now();
+      if (now - self->state.last_flush > self->state.flush_interval) {
+        self->state.writer.flush();
+        self->state.last_flush = now;
+        self->state.dirty = false;
+      } else {
+        self->state.dirty = true;
+        if (!self->state.flush_scheduled) {
+          self->state.flush_scheduled = true;
+          self->delayed_send(self, self->state.flush_interval,
+                             flush_atom::value);
         }
       }
     },
+    [=](flush_atom) {
+      self->state.flush_scheduled = false;
+      if (self->state.dirty) {
+        self->state.writer.flush();
+        self->state.last_flush = steady_clock::now();
+        self->state.dirty = false;
+      }
+    },
     [=](const uuid& id, const query_statistics&) {
       VAST_DEBUG(self, "got query statistics from", id);
     },
@@ -1,6 +1,8 @@
 #ifndef VAST_SYSTEM_SOURCE_HPP
 #define VAST_SYSTEM_SOURCE_HPP
 
+#include <algorithm>
+#include <chrono>
 #include <unordered_map>
 
 #include "vast/logger.hpp"
@@ -13,12 +15,13 @@
 #include "vast/concept/printable/vast/error.hpp"
 #include "vast/concept/printable/vast/expression.hpp"
 #include "vast/detail/assert.hpp"
+#include "vast/checker.hpp"
 #include "vast/error.hpp"
 #include "vast/event.hpp"
 #include "vast/expected.hpp"
 #include "vast/expression.hpp"
-#include "vast/expression_visitors.hpp"
 #include "vast/schema.hpp"
+#include "vast/time.hpp"
 
 #include "vast/system/accountant.hpp"
 #include "vast/system/atoms.hpp"
@@ -33,6 +36,14 @@ struct Reader {
 
   expected<result> read();
 
+  /// Reads up to *max* events and appends them to *xs*, skipping over bogus
+  /// input. An error signals that the reader cannot produce any more events,
+  /// e.g., `ec::end_of_input`, but events appended up to this point remain
+  /// valid. Appending fewer than *max* events without an error signals that
+  /// the reader would have to block for more input, e.g., on a live capture
+  /// timeout.
+  expected<void> read(std::vector<event>& xs, size_t max);
+
   expected<void> schema(vast::schema&);
 
   expected<vast::schema> schema() const;
@@ -41,15 +52,52 @@ struct Reader {
 };
 #endif
 
+/// Computes the size of the next batch such that filling it takes roughly
+/// *target* at the rate observed for the last batch. The result moves at most
+/// halfway towards the ideal size and at most doubles per step to dampen
+/// oscillation.
+/// @param size The current batch size.
+/// @param events The number of events in the last batch.
+/// @param runtime The time it took to produce the last batch.
+/// @param target The desired time to produce a batch.
+/// @param congested Whether the sink ran out of credit since the last batch.
+///                  Smaller batches would only add per-batch overhead to an
+///                  already saturated sink, so we do not shrink in this case.
+/// @returns The new batch size in *[min_size, max_size]*.
+inline uint64_t adapt_batch_size(uint64_t size, uint64_t events,
+                                 timespan runtime, timespan target,
+                                 bool congested, uint64_t min_size,
+                                 uint64_t max_size) {
+  using seconds = std::chrono::duration<double>;
+  auto ideal = double(max_size);
+  auto secs = std::chrono::duration_cast<seconds>(runtime).count();
+  if (secs > 0)
+    ideal = events / secs * std::chrono::duration_cast<seconds>(target).count();
+  if (congested)
+    ideal = std::max(ideal, double(size));
+  auto next = std::min((size + ideal) / 2, size * 2.0);
+  return std::max(min_size, std::min(max_size, uint64_t(next)));
+}
+
 /// The source state.
 /// @tparam Reader The reader type, which must model the *Reader* concept.
 template <class Reader>
 struct source_state {
+  static constexpr size_t min_batch_size = 128;
   static constexpr size_t max_batch_size = 1 << 20;
+  // The number of events to read at once when adapting the batch size, which
+  // bounds how long a batch can overshoot the latency target.
+  static constexpr size_t max_read_size = 1024;
   uint64_t batch_size = 65536;
+  bool adaptive = true;
+  timespan target_latency = std::chrono::seconds(1);
+  uint64_t max_inflight = 4;
+  uint64_t inflight = 0;
+  bool stalled = false;
+  bool congested = false;
   std::vector<event> events;
   expression filter;
-  std::unordered_map<type, expression> checkers;
+  std::unordered_map<type, checker> checkers;
   std::chrono::steady_clock::time_point start;
   accountant_type accountant;
   caf::actor sink;
@@ -93,34 +141,59 @@ source(caf::stateful_actor<source_state<Reader>>* self, Reader&& reader) {
       // have completed a batch.
       auto start = steady_clock::now();
       auto done = false;
-      while (self->state.events.size() < self->state.batch_size) {
-        auto e = self->state.reader.read();
-        if (e) {
-          if (!is<none>(self->state.filter)) {
-            auto& checker = self->state.checkers[e->type()];
-            if (is<none>(checker)) {
-              auto x = tailor(self->state.filter, e->type());
-              VAST_ASSERT(x);
-              checker = std::move(*x);
+      auto& batch = self->state.events;
+      // When adapting the batch size, we also cut a batch short once it
+      // exceeds the latency target, so that slow feeds become visible early.
+      // To check the deadline regularly, we read in small steps.
+      auto deadline = start + self->state.target_latency;
+      while (batch.size() < self->state.batch_size) {
+        if (self->state.adaptive && !batch.empty()
+            && steady_clock::now() >= deadline)
+          break;
+        auto first = batch.size();
+        auto max = self->state.batch_size - first;
+        if (self->state.adaptive)
+          max = std::min(max, uint64_t{source_state<Reader>::max_read_size});
+        auto r = self->state.reader.read(batch, max);
+        auto produced = batch.size() - first;
+        if (!is<none>(self->state.filter)) {
+          // Events tend to arrive in runs that share the same type instance,
+          // so we only consult the checker map when the instance changes.
+          auto same_instance = [](vast::type const& x, vast::type const& y) {
+            return &expose(const_cast<vast::type&>(x))
+                   == &expose(const_cast<vast::type&>(y));
+          };
+          vast::type prev;
+          vast::checker const* check = nullptr;
+          auto rejected = [&](event const& e) {
+            if (!check || !same_instance(prev, e.type())) {
+              auto& x = self->state.checkers[e.type()];
+              if (!x) {
+                auto compiled = make_checker(self->state.filter, e.type());
+                VAST_ASSERT(compiled);
+                x = std::move(*compiled);
+              }
+              prev = e.type();
+              check = &x;
             }
-            if (!visit(event_evaluator{*e}, checker))
-              continue;
-          }
-          self->state.events.push_back(std::move(*e));
-        } else if (!e.error()) {
-          continue; // Try again.
-        } else {
-          if (e.error() == ec::parse_error) {
-            VAST_WARNING(self->system().render(e.error()));
-            continue; // Just skip bogous events.
-          } else if (e.error() == ec::end_of_input) {
-            VAST_INFO(self->system().render(e.error()));
-          } else {
-            VAST_ERROR(self->system().render(e.error()));
-          }
+            return !(*check)(e);
+          };
+          batch.erase(std::remove_if(batch.begin() + first, batch.end(),
+                                     rejected),
+                      batch.end());
+        }
+        if (!r) {
+          if (r.error() == ec::end_of_input)
+            VAST_INFO(self->system().render(r.error()));
+          else
+            VAST_ERROR(self->system().render(r.error()));
           done = true;
           break;
         }
+        // A short read means that no more input is available right now, so
+        // we ship what we have rather than wait for the batch to fill up.
+        if (produced < max)
+          break;
       }
       auto stop = steady_clock::now();
       // Ship the current batch.
@@ -137,21 +210,49 @@ source(caf::stateful_actor<source_state<Reader>>* self, Reader&& reader) {
           self->send(self->state.accountant, "source.batch.events", events);
           self->send(self->state.accountant, "source.batch.rate", rate);
         }
-        self->send(self->state.sink, std::move(self->state.events));
+        if (self->state.adaptive) {
+          auto n = adapt_batch_size(self->state.batch_size, events,
+                                    duration_cast<timespan>(runtime),
+                                    self->state.target_latency,
+                                    self->state.congested,
+                                    source_state<Reader>::min_batch_size,
+                                    source_state<Reader>::max_batch_size);
+          if (n != self->state.batch_size)
+            VAST_DEBUG(self, "adapts batch size:", self->state.batch_size,
+                       "->", n);
+          self->state.batch_size = n;
+          self->state.congested = false;
+        }
+        // Each batch consumes one credit, which the sink returns after the
+        // batch has made it into archive and index. Once we run out of
+        // credit, we stop reading until an acknowledgement arrives. This
+        // keeps a slow sink from letting batches pile up in memory.
+        ++self->state.inflight;
+        auto resume = [=] {
+          VAST_ASSERT(self->state.inflight > 0);
+          --self->state.inflight;
+          if (self->state.stalled
+              && self->state.inflight < self->state.max_inflight) {
+            self->state.stalled = false;
+            self->send(self, run_atom::value);
+          }
+        };
+        self->request(self->state.sink, infinite,
+                      std::move(self->state.events)).then(
+          [=](ok_atom) { resume(); },
+          [=](error const& e) {
+            VAST_WARNING(self, "got no acknowledgement for batch:",
+                         self->system().render(e));
+            resume();
+          }
+        );
         self->state.events = {};
         self->state.events.reserve(self->state.batch_size);
-        // FIXME: if we do not give the stdlib implementation a hint to yield
-        // here, this actor can monopolize all available resources. In
-        // particular, we encountered a scenario where it prevented the BASP
-        // broker from a getting a chance to operate, thereby queuing up
-        // all event batches locally and running out of memory, as opposed to
-        // sending them out as soon as possible. This yield fix temporarily
-        // works around a deeper issue in CAF, which needs to be addressed in
-        // the future.
-        std::this_thread::yield();
       }
       if (done)
         self->send_exit(self, exit_reason::normal);
+      else if (self->state.inflight >= self->state.max_inflight)
+        self->state.stalled = self->state.congested = true;
       else
         self->send(self, run_atom::value);
     },
@@ -160,10 +261,29 @@ source(caf::stateful_actor<source_state<Reader>>* self, Reader&& reader) {
         VAST_WARNING(self, "ignores too large batch size:", batch_size);
         return;
       }
-      VAST_DEBUG(self, "sets batch size to", batch_size);
+      VAST_DEBUG(self, "sets fixed batch size to", batch_size);
       self->state.batch_size = batch_size;
+      self->state.adaptive = false;
       self->state.events.reserve(batch_size);
     },
+    [=](batch_atom, timespan target_latency) {
+      VAST_DEBUG(self, "adapts batch size to latency target", target_latency);
+      self->state.target_latency = target_latency;
+      self->state.adaptive = true;
+    },
+    [=](credit_atom, uint64_t max_inflight) {
+      if (max_inflight == 0) {
+        VAST_WARNING(self, "ignores zero in-flight batches");
+        return;
+      }
+      VAST_DEBUG(self, "allows", max_inflight, "batches in flight");
+      self->state.max_inflight = max_inflight;
+      if (self->state.stalled
+          && self->state.inflight < self->state.max_inflight) {
+        self->state.stalled = false;
+        self->send(self, run_atom::value);
+      }
+    },
     [=](get_atom, schema_atom) -> result<schema> {
       auto sch = self->state.reader.schema();
       if (sch)
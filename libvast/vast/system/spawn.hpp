@@ -25,6 +25,8 @@ expected<caf::actor> spawn_importer(caf::local_actor* self, options& opts);
 
 expected<caf::actor> spawn_index(caf::local_actor* self, options& opts);
 
+expected<caf::actor> spawn_matcher(caf::local_actor* self, options& opts);
+
 expected<caf::actor> spawn_metastore(caf::local_actor* self, options& opts);
 
 expected<caf::actor> spawn_profiler(caf::local_actor* self, options& opts);
@@ -0,0 +1,33 @@
+#ifndef VAST_SYSTEM_STREAM_MATCHER_HPP
+#define VAST_SYSTEM_STREAM_MATCHER_HPP
+
+#include <unordered_map>
+#include <vector>
+
+#include <caf/actor.hpp>
+#include <caf/stateful_actor.hpp>
+
+#include "vast/query_matcher.hpp"
+
+namespace vast {
+namespace system {
+
+struct stream_matcher_state {
+  query_matcher matcher;
+  std::unordered_map<query_matcher::query_id, caf::actor> subscribers;
+  query_matcher::query_id next_id = 0;
+  char const* name = "stream-matcher";
+};
+
+/// Matches the events flowing out of IMPORTERs against the standing queries
+/// of continuous EXPORTERs. An EXPORTER subscribes with a `subscribe_atom` and
+/// its expression and then receives its matches as `continuous_atom` along
+/// with a vector of events. Subscriptions end when the EXPORTER terminates or
+/// sends a `delete_atom`.
+/// @param self The actor handle.
+caf::behavior stream_matcher(caf::stateful_actor<stream_matcher_state>* self);
+
+} // namespace system
+} // namespace vast
+
+#endif
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 #include "vast/ewah_bitmap.hpp"
 #include "vast/bitmap.hpp"
@@ -212,6 +213,56 @@ private:
   bitmap_index_type bmi_;
 };
 
+/// An index for timestamps that exploits the near-sorted arrival order of
+/// events. Instead of a bitmap per range, the index keeps a sparse sorted
+/// array of *(time, first ID)* checkpoints, one for each distinct (binned)
+/// timestamp in arrival order. Events that arrive out of order, i.e., with a
+/// timestamp smaller than the latest checkpoint, go into a separate exception
+/// index. A lookup computes the matching ID range via binary search over the
+/// checkpoints and then patches in the exceptions.
+class timestamp_index : public value_index {
+public:
+  using value_type = timespan::rep;
+
+  /// The binning policy, which equals the one of `arithmetic_index<timestamp>`.
+  using binner_type = decimal_binner<9>; // nanoseconds -> seconds
+
+  /// The index for out-of-order timestamps.
+  using exception_index =
+    bitmap_index<
+      value_type,
+      multi_level_coder<range_coder<bitmap>>,
+      binner_type
+    >;
+
+  /// Constructs a timestamp index.
+  /// @param b The base for the decomposition of out-of-order timestamps.
+  explicit timestamp_index(base b = base::uniform<64>(10));
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, timestamp_index& idx) {
+    return f(static_cast<value_index&>(idx), idx.times_, idx.ids_,
+             idx.exceptions_, idx.exception_index_);
+  }
+
+private:
+  bool push_back_impl(data const& x, size_type skip) override;
+
+  expected<bitmap>
+  lookup_impl(relational_operator op, data const& x) const override;
+
+  // Computes the positions of all in-order events in *[first, last)*.
+  bitmap in_order(size_type first, size_type last) const;
+
+  // Maps a checkpoint position to the first ID it covers.
+  size_type first_id(size_t i) const;
+
+  std::vector<value_type> times_;
+  std::vector<size_type> ids_;
+  bitmap exceptions_;
+  exception_index exception_index_;
+};
+
 /// An index for strings.
 class string_index : public value_index {
 public:
@@ -380,6 +431,60 @@ private:
   vast::type value_type_;
 };
 
+/// An index for vectors and sets that indexes elements independent of their
+/// position. All elements go into a single value index, one *slot* per
+/// element, such that a container with *k* elements occupies *k* consecutive
+/// slots. Two bitmaps map slots back to containers: one marks the first slot
+/// of every non-empty container, and one marks the IDs of non-empty
+/// containers. A membership query thus requires a single lookup, regardless
+/// of the container length.
+class element_index : public value_index {
+public:
+  /// Constructs an element index of a given type.
+  /// @param t The element type of the container.
+  /// @param max_size The maximum number of elements permitted per container.
+  ///                 Longer containers will be trimmed at the end.
+  element_index(vast::type t = {}, size_t max_size = 1024);
+
+  friend void serialize(caf::serializer& sink, element_index const& idx);
+  friend void serialize(caf::deserializer& source, element_index& idx);
+
+private:
+  template <class Container>
+  bool push_back_ctnr(Container& c, size_type skip) {
+    owners_.append_bits(false, skip);
+    auto n = std::min(c.size(), max_size_);
+    if (n == 0) {
+      owners_.append_bit(false);
+      return true;
+    }
+    if (!elements_) {
+      elements_ = value_index::make(value_type_);
+      if (!elements_)
+        return false;
+    }
+    auto x = c.begin();
+    for (auto i = 0u; i < n; ++i)
+      if (!elements_->push_back(*x++))
+        return false;
+    starts_.append_bit(true);
+    starts_.append_bits(false, n - 1);
+    owners_.append_bit(true);
+    return true;
+  }
+
+  bool push_back_impl(data const& x, size_type skip) override;
+
+  expected<bitmap>
+  lookup_impl(relational_operator op, data const& x) const override;
+
+  std::unique_ptr<value_index> elements_;
+  ewah_bitmap starts_;
+  ewah_bitmap owners_;
+  size_t max_size_;
+  vast::type value_type_;
+};
+
 namespace detail {
 
 struct value_index_inspect_helper {
@@ -420,7 +525,7 @@ struct value_index_inspect_helper {
     }
 
     result_type operator()(timestamp_type const&) const {
-      return f_(static_cast<arithmetic_index<timestamp>&>(idx_));
+      return f_(static_cast<timestamp_index&>(idx_));
     }
 
     result_type operator()(string_type const&) const {
@@ -440,11 +545,11 @@ struct value_index_inspect_helper {
     }
 
     result_type operator()(vector_type const&) const {
-      return f_(static_cast<sequence_index&>(idx_));
+      return f_(static_cast<element_index&>(idx_));
     }
 
     result_type operator()(set_type const&) const {
-      return f_(static_cast<sequence_index&>(idx_));
+      return f_(static_cast<element_index&>(idx_));
     }
 
     result_type operator()(alias_type const& t) const {
@@ -484,7 +589,7 @@ struct value_index_inspect_helper {
     }
 
     result_type operator()(timestamp_type const&) const {
-      return std::make_unique<arithmetic_index<timestamp>>();
+      return std::make_unique<timestamp_index>();
     }
 
     result_type operator()(string_type const&) const {
@@ -504,11 +609,11 @@ struct value_index_inspect_helper {
     }
 
     result_type operator()(vector_type const&) const {
-      return std::make_unique<sequence_index>();
+      return std::make_unique<element_index>();
     }
 
     result_type operator()(set_type const&) const {
-      return std::make_unique<sequence_index>();
+      return std::make_unique<element_index>();
     }
 
     result_type operator()(alias_type const& t) const {
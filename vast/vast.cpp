@@ -398,6 +398,7 @@ int main(int argc, char* argv[]) {
         spawn_component("metastore"),
         spawn_component("archive"),
         spawn_component("index"),
+        spawn_component("matcher"),
         spawn_component("importer")
       );
       if (err) {